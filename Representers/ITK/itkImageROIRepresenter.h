@@ -101,7 +101,8 @@ public:
 	ImageROIRepresenter();
 	virtual ~ImageROIRepresenter();
 
-	static unsigned GetDimensions() { return 1; }
+	static const unsigned Dimensions = 1;
+	static unsigned GetDimensions() { return Dimensions; }
 	static std::string GetName() { return "itkImageROIRepresenter"; }
 
 	const DomainType& GetDomain() const { return m_domain; }
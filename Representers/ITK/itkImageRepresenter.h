@@ -95,7 +95,8 @@ public:
 	ImageRepresenter();
 	virtual ~ImageRepresenter();
 
-	static unsigned GetDimensions() { return 1; }
+	static const unsigned Dimensions = 1;
+	static unsigned GetDimensions() { return Dimensions; }
 	static std::string GetName() { return "itkImageRepresenter"; }
 
 	const DomainType& GetDomain() const { return m_domain; }
@@ -109,7 +109,8 @@ public:
 	MeshRepresenter();
 	virtual ~MeshRepresenter();
 
-	static unsigned GetDimensions() { return MeshDimension; }
+	static const unsigned Dimensions = MeshDimension;
+	static unsigned GetDimensions() { return Dimensions; }
 
 	static std::string GetName() { return "itkMeshRepresenter"; }
 
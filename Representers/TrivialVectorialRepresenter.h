@@ -92,7 +92,8 @@ public:
 
 
 	static std::string GetName() { return "TrivialVectorialRepresenter"; }
-	static unsigned GetDimensions() { return 1; }
+	static const unsigned Dimensions = 1;
+	static unsigned GetDimensions() { return Dimensions; }
 
 	const DomainType& GetDomain() const { return m_domain; }
 
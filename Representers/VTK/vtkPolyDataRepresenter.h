@@ -102,7 +102,8 @@ public:
 
 
 	static std::string GetName() { return "vtkPolyDataRepresenter"; }
-	static unsigned GetDimensions() { return 3; }
+	static const unsigned Dimensions = 3;
+	static unsigned GetDimensions() { return Dimensions; }
 
 	const DomainType& GetDomain() const { return m_domain; }
 
@@ -86,7 +86,8 @@ public:
 
 
 
-	static unsigned GetDimensions() { return  TDimensions; }
+	static const unsigned Dimensions = TDimensions;
+	static unsigned GetDimensions() { return Dimensions; }
 	const DomainType& GetDomain() const  { return m_domain; }
 
 	static std::string GetName() { return "vtkStructuredPointsRepresenter"; }
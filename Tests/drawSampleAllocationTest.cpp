@@ -0,0 +1,140 @@
+/*
+ * This file is part of the statismo library.
+ *
+ * Author: Marcel Luethi (marcel.luethi@unibas.ch)
+ *
+ * Copyright (c) 2011 University of Basel
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ *
+ * Neither the name of the project's author nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+ * TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS addINTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+// Every heap allocation made by Eigen is reported through eigen_assert when EIGEN_RUNTIME_NO_MALLOC
+// is defined and malloc is disallowed. We count these reports instead of aborting, such that the test
+// can report the number of allocations.
+static unsigned long eigenAllocationCount = 0;
+#define EIGEN_RUNTIME_NO_MALLOC
+#define eigen_assert(x) do { if (!(x)) { ++eigenAllocationCount; } } while (0)
+
+#include "TrivialVectorialRepresenter.h"
+#include "statismo/StatisticalModel.h"
+#include "statismo/PCAModelBuilder.h"
+#include "statismo/DataManager.h"
+
+#include <cstdlib>
+#include <new>
+
+// all allocations that do not go through Eigen (e.g. std containers) are counted by the global operator new.
+static bool countAllocations = false;
+static unsigned long operatorNewCount = 0;
+
+void* operator new(std::size_t size) {
+	if (countAllocations) ++operatorNewCount;
+	void* p = std::malloc(size);
+	if (p == 0) throw std::bad_alloc();
+	return p;
+}
+
+void operator delete(void* p) {
+	std::free(p);
+}
+
+// with sized deallocation (C++14), the compiler can call this overload instead, which would otherwise free the
+// memory allocated by the malloc above with the library's operator delete.
+void operator delete(void* p, std::size_t) {
+	std::free(p);
+}
+
+typedef TrivialVectorialRepresenter RepresenterType;
+
+
+/**
+ * Checks that the sampling methods DrawSampleVectorInto and DrawSampleAtPointInto do not allocate memory.
+ * The test fails if any heap allocation is made in the sampling loops.
+ */
+int main(int argc, char* argv[]) {
+
+	typedef statismo::PCAModelBuilder<RepresenterType> ModelBuilderType;
+	typedef statismo::StatisticalModel<RepresenterType> StatisticalModelType;
+	typedef statismo::DataManager<RepresenterType> DataManagerType;
+
+	const unsigned numberOfPoints = 10000;
+	const unsigned numberOfSamples = 20;
+	const unsigned numberOfIterations = 1000;
+
+	try {
+		statismo::shared_ptr<RepresenterType> representer(RepresenterType::Create(numberOfPoints));
+		statismo::shared_ptr<DataManagerType> dataManager(DataManagerType::Create(representer.get()));
+
+		for (unsigned i = 0; i < numberOfSamples; i++) {
+			statismo::VectorType dataset = statismo::VectorType::Random(numberOfPoints);
+			dataManager->AddDataset(dataset, "dataset");
+		}
+
+		statismo::shared_ptr<ModelBuilderType> pcaModelBuilder(ModelBuilderType::Create());
+		statismo::shared_ptr<StatisticalModelType> model(pcaModelBuilder->BuildNewModel(dataManager->GetSampleDataStructure(), 0.01));
+
+		statismo::VectorType coefficients = statismo::VectorType::Random(model->GetNumberOfPrincipalComponents());
+		statismo::VectorType sample(numberOfPoints);
+		statismo::ScalarType value = 0;
+
+		// make sure that the result agrees with the allocating version
+		model->DrawSampleVectorInto(coefficients, sample.data());
+		if ((sample - model->DrawSampleVector(coefficients)).norm() > 1e-5) {
+			std::cout << "DrawSampleVectorInto differs from DrawSampleVector" << std::endl;
+			return EXIT_FAILURE;
+		}
+
+		eigenAllocationCount = 0;
+		Eigen::internal::set_is_malloc_allowed(false);
+		countAllocations = true;
+
+		for (unsigned i = 0; i < numberOfIterations; i++) {
+			model->DrawSampleVectorInto(coefficients, sample.data(), i % 2 == 0);
+		}
+
+		for (unsigned i = 0; i < numberOfIterations * 100; i++) {
+			model->DrawSampleAtPointInto(coefficients, i % numberOfPoints, &value, i % 2 == 0);
+		}
+
+		countAllocations = false;
+		Eigen::internal::set_is_malloc_allowed(true);
+
+		if (eigenAllocationCount + operatorNewCount != 0) {
+			std::cout << "the sampling methods made " << eigenAllocationCount + operatorNewCount << " heap allocations" << std::endl;
+			return EXIT_FAILURE;
+		}
+	}
+	catch (statismo::StatisticalModelException& e) {
+		std::cout << e.what() << std::endl;
+		return EXIT_FAILURE;
+	}
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,138 @@
+/*
+ * This file is part of the statismo library.
+ *
+ * Author: Marcel Luethi (marcel.luethi@unibas.ch)
+ *
+ * Copyright (c) 2011 University of Basel
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ *
+ * Neither the name of the project's author nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+ * TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS addINTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#include "TrivialVectorialRepresenter.h"
+#include "statismo/StatisticalModel.h"
+#include "statismo/PCAModelBuilder.h"
+#include "statismo/DataManager.h"
+
+#include <Eigen/Cholesky>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+
+typedef TrivialVectorialRepresenter RepresenterType;
+typedef statismo::StatisticalModel<RepresenterType> StatisticalModelType;
+
+
+// returns the log density of N(mu, C) at the given sample, where C = W W^T + sigma^2 I is formed explicitly
+double computeDenseGaussianLogDensity(const StatisticalModelType* model, const statismo::VectorType& sample) {
+
+	statismo::MatrixTypeDoublePrecision W = model->GetPCABasisMatrix().cast<double>();
+	unsigned p = W.rows();
+	statismo::MatrixTypeDoublePrecision C = W * W.transpose();
+	C.diagonal().array() += model->GetNoiseVariance();
+
+	Eigen::LLT<statismo::MatrixTypeDoublePrecision> llt(C);
+	statismo::VectorTypeDoublePrecision r = (sample - model->GetMeanVector()).cast<double>();
+	statismo::VectorTypeDoublePrecision z = llt.matrixL().solve(r);
+	double logDeterminant = 2 * statismo::MatrixTypeDoublePrecision(llt.matrixL()).diagonal().array().log().sum();
+
+	return -0.5 * (p * std::log(2 * M_PI) + logDeterminant + z.squaredNorm());
+}
+
+
+/**
+ * Compares ComputeLogProbabilityOfDataset, i.e. the log-likelihood of the PPCA model, with the log density of the
+ * corresponding Gaussian distribution with the dense covariance matrix. For a model without noise, it is compared with
+ * the log density of the coefficients.
+ */
+int main(int argc, char* argv[]) {
+
+	typedef statismo::PCAModelBuilder<RepresenterType> ModelBuilderType;
+	typedef statismo::DataManager<RepresenterType> DataManagerType;
+
+	const unsigned numberOfPoints = 40;
+	const unsigned numberOfSamples = 10;
+
+	try {
+		statismo::shared_ptr<RepresenterType> representer(RepresenterType::Create(numberOfPoints));
+		statismo::shared_ptr<DataManagerType> dataManager(DataManagerType::Create(representer.get()));
+
+		statismo::RandomStream stream(5);
+		for (unsigned i = 0; i < numberOfSamples; i++) {
+			statismo::VectorType dataset = statismo::Utils::generateNormalVector(numberOfPoints, stream) * 3;
+			dataManager->AddDataset(dataset, "dataset");
+		}
+
+		statismo::shared_ptr<ModelBuilderType> modelBuilder(ModelBuilderType::Create());
+		bool ok = true;
+
+		statismo::shared_ptr<StatisticalModelType> model(modelBuilder->BuildNewModel(dataManager->GetSampleDataStructure(), 0.5));
+		for (unsigned i = 0; i < 5; i++) {
+			// the first dataset is the mean, the others are random samples, which are partly outside of the model
+			statismo::VectorType sample = model->GetMeanVector();
+			if (i > 0) {
+				sample = model->DrawSampleVector(statismo::Utils::generateNormalVector(model->GetNumberOfPrincipalComponents(), stream), stream);
+				sample += statismo::Utils::generateNormalVector(numberOfPoints, stream) * (i - 1);
+			}
+
+			double logProbability = model->ComputeLogProbabilityOfDataset(sample);
+			double expected = computeDenseGaussianLogDensity(model.get(), sample);
+			if (std::fabs(logProbability - expected) > 1e-4 * std::fabs(expected)) {
+				std::cout << "the log probability is " << logProbability << " instead of " << expected << std::endl;
+				ok = false;
+			}
+
+			double probability = model->ComputeProbabilityOfDataset(sample);
+			if (std::fabs(probability - std::exp(expected)) > 1e-3 * std::exp(expected)) {
+				std::cout << "the probability is " << probability << " instead of " << std::exp(expected) << std::endl;
+				ok = false;
+			}
+		}
+
+		statismo::shared_ptr<StatisticalModelType> pcaModel(modelBuilder->BuildNewModel(dataManager->GetSampleDataStructure(), 0));
+		statismo::VectorType coefficients = statismo::Utils::generateNormalVector(pcaModel->GetNumberOfPrincipalComponents(), stream);
+		statismo::VectorType sample = pcaModel->DrawSampleVector(coefficients);
+		double logProbability = pcaModel->ComputeLogProbabilityOfDataset(sample);
+		double expected = -0.5 * (coefficients.rows() * std::log(2 * M_PI) + coefficients.squaredNorm());
+		if (std::fabs(logProbability - expected) > 1e-4 * std::fabs(expected)) {
+			std::cout << "the log probability of the model without noise is " << logProbability << " instead of " << expected << std::endl;
+			ok = false;
+		}
+
+		if (!ok) {
+			return EXIT_FAILURE;
+		}
+	}
+	catch (statismo::StatisticalModelException& e) {
+		std::cout << e.what() << std::endl;
+		return EXIT_FAILURE;
+	}
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,150 @@
+/*
+ * This file is part of the statismo library.
+ *
+ * Author: Marcel Luethi (marcel.luethi@unibas.ch)
+ *
+ * Copyright (c) 2011 University of Basel
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ *
+ * Neither the name of the project's author nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+ * TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS addINTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#include "TrivialVectorialRepresenter.h"
+#include "statismo/StatisticalModel.h"
+#include "statismo/PCAModelBuilder.h"
+#include "statismo/MarginalModelBuilder.h"
+#include "statismo/DataManager.h"
+
+#include <Eigen/Eigenvalues>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+typedef TrivialVectorialRepresenter RepresenterType;
+typedef statismo::StatisticalModel<RepresenterType> StatisticalModelType;
+
+
+/**
+ * Builds the marginal model of a model on a subset of its points, and checks that after saving and loading it,
+ * its mean consists of the entries of the original mean on the subset, its variances are the eigenvalues of W_s^T W_s,
+ * where W_s are the rows of the original PCA basis on the subset, and its covariance is W_s W_s^T.
+ * Checks further that a subset with a duplicate point id is rejected.
+ */
+int main(int argc, char* argv[]) {
+
+	typedef statismo::PCAModelBuilder<RepresenterType> ModelBuilderType;
+	typedef statismo::MarginalModelBuilder<RepresenterType> MarginalModelBuilderType;
+	typedef MarginalModelBuilderType::StatisticalModelType MarginalModelType;
+	typedef statismo::DataManager<RepresenterType> DataManagerType;
+
+	const unsigned numberOfPoints = 200;
+	const unsigned numberOfSamples = 10;
+
+	try {
+		statismo::shared_ptr<RepresenterType> representer(RepresenterType::Create(numberOfPoints));
+		statismo::shared_ptr<DataManagerType> dataManager(DataManagerType::Create(representer.get()));
+
+		statismo::RandomStream stream(23);
+		for (unsigned i = 0; i < numberOfSamples; i++) {
+			statismo::VectorType dataset = statismo::Utils::generateNormalVector(numberOfPoints, stream);
+			dataManager->AddDataset(dataset, "dataset");
+		}
+
+		statismo::shared_ptr<ModelBuilderType> modelBuilder(ModelBuilderType::Create());
+		statismo::shared_ptr<StatisticalModelType> model(modelBuilder->BuildNewModel(dataManager->GetSampleDataStructure(), 0.1));
+
+		std::vector<unsigned> pointIds;
+		for (unsigned i = 0; i < 30; i++) {
+			pointIds.push_back((i * 37) % numberOfPoints);
+		}
+
+		statismo::shared_ptr<MarginalModelBuilderType> marginalModelBuilder(MarginalModelBuilderType::Create());
+		statismo::shared_ptr<MarginalModelType> marginalModel(marginalModelBuilder->BuildNewModelFromModel(model.get(), pointIds));
+		marginalModel->Save("marginalModel.h5");
+		statismo::shared_ptr<MarginalModelType> loadedModel(MarginalModelType::Load("marginalModel.h5"));
+
+		const statismo::MatrixType& W = model->GetPCABasisMatrix();
+		statismo::VectorType subsetMean(pointIds.size());
+		statismo::MatrixTypeDoublePrecision subsetW(pointIds.size(), W.cols());
+		for (unsigned i = 0; i < pointIds.size(); i++) {
+			subsetMean[i] = model->GetMeanVector()[pointIds[i]];
+			subsetW.row(i) = W.row(pointIds[i]).cast<double>();
+		}
+		Eigen::SelfAdjointEigenSolver<statismo::MatrixTypeDoublePrecision> es(subsetW.transpose() * subsetW);
+		statismo::VectorTypeDoublePrecision eigenvalues = es.eigenvalues().reverse();
+
+		bool ok = true;
+		if (loadedModel->GetRepresenter()->GetPointIds() != pointIds) {
+			std::cout << "the point ids of the loaded representer differ" << std::endl;
+			ok = false;
+		}
+		if ((loadedModel->GetMeanVector() - subsetMean).norm() > 1e-5 * subsetMean.norm()) {
+			std::cout << "the mean of the loaded marginal model differs" << std::endl;
+			ok = false;
+		}
+
+		const statismo::VectorType& variances = loadedModel->GetPCAVarianceVector();
+		if (variances.rows() != eigenvalues.rows()) {
+			std::cout << "the marginal model has " << variances.rows() << " instead of " << eigenvalues.rows() << " components" << std::endl;
+			ok = false;
+		}
+		else if ((variances.cast<double>() - eigenvalues).norm() > 1e-4 * eigenvalues.norm()) {
+			std::cout << "the variances of the marginal model are not the eigenvalues of W_s^T W_s" << std::endl;
+			ok = false;
+		}
+
+		statismo::MatrixTypeDoublePrecision marginalW = loadedModel->GetPCABasisMatrix().cast<double>();
+		statismo::MatrixTypeDoublePrecision covariance = subsetW * subsetW.transpose();
+		if ((marginalW * marginalW.transpose() - covariance).norm() > 1e-4 * covariance.norm()) {
+			std::cout << "the covariance of the marginal model differs" << std::endl;
+			ok = false;
+		}
+
+		std::vector<unsigned> duplicatePointIds(pointIds);
+		duplicatePointIds.push_back(pointIds[3]);
+		try {
+			statismo::shared_ptr<MarginalModelType> invalidModel(marginalModelBuilder->BuildNewModelFromModel(model.get(), duplicatePointIds));
+			std::cout << "a duplicate point id was accepted" << std::endl;
+			ok = false;
+		}
+		catch (statismo::StatisticalModelException&) {
+		}
+
+		if (!ok) {
+			return EXIT_FAILURE;
+		}
+	}
+	catch (statismo::StatisticalModelException& e) {
+		std::cout << e.what() << std::endl;
+		return EXIT_FAILURE;
+	}
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,129 @@
+/*
+ * This file is part of the statismo library.
+ *
+ * Author: Marcel Luethi (marcel.luethi@unibas.ch)
+ *
+ * Copyright (c) 2011 University of Basel
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ *
+ * Neither the name of the project's author nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+ * TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS addINTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#include "TrivialVectorialRepresenter.h"
+#include "statismo/StatisticalModel.h"
+#include "statismo/PCAModelBuilder.h"
+#include "statismo/ModelInstance.h"
+#include "statismo/DataManager.h"
+
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+typedef TrivialVectorialRepresenter RepresenterType;
+typedef statismo::StatisticalModel<RepresenterType> StatisticalModelType;
+typedef statismo::ModelInstance<RepresenterType> ModelInstanceType;
+
+
+// checks that the sample of the instance is the sample of the model for the coefficients of the instance
+bool checkInstance(const StatisticalModelType* model, const ModelInstanceType* instance, const std::string& name) {
+	statismo::VectorType sample = model->DrawSampleVector(instance->GetCoefficients());
+	double error = (instance->GetSampleVector() - sample).norm() / sample.norm();
+	if (error > 1e-5) {
+		std::cout << name << ": the sample of the instance differs from the sample of the model (relative error " << error << ")" << std::endl;
+		return false;
+	}
+	return true;
+}
+
+
+/**
+ * Checks that the sample of a ModelInstance equals the sample drawn by the model, after single and multiple coefficient
+ * updates, over enough updates to trigger the recomputation from scratch, and after setting all the coefficients.
+ */
+int main(int argc, char* argv[]) {
+
+	typedef statismo::PCAModelBuilder<RepresenterType> ModelBuilderType;
+	typedef statismo::DataManager<RepresenterType> DataManagerType;
+
+	const unsigned numberOfPoints = 200;
+	const unsigned numberOfSamples = 10;
+
+	try {
+		statismo::shared_ptr<RepresenterType> representer(RepresenterType::Create(numberOfPoints));
+		statismo::shared_ptr<DataManagerType> dataManager(DataManagerType::Create(representer.get()));
+
+		statismo::RandomStream stream(31);
+		for (unsigned i = 0; i < numberOfSamples; i++) {
+			statismo::VectorType dataset = statismo::Utils::generateNormalVector(numberOfPoints, stream);
+			dataManager->AddDataset(dataset, "dataset");
+		}
+
+		statismo::shared_ptr<ModelBuilderType> modelBuilder(ModelBuilderType::Create());
+		statismo::shared_ptr<StatisticalModelType> model(modelBuilder->BuildNewModel(dataManager->GetSampleDataStructure(), 0.1));
+		unsigned k = model->GetNumberOfPrincipalComponents();
+
+		statismo::shared_ptr<ModelInstanceType> instance(ModelInstanceType::Create(model.get()));
+		bool ok = checkInstance(model.get(), instance.get(), "mean");
+
+		// more single updates than components, such that the sample is recomputed at least once
+		statismo::VectorType values = statismo::Utils::generateNormalVector(3 * k, stream);
+		for (unsigned i = 0; i < 3 * k; i++) {
+			instance->SetCoefficient((i * 7) % k, values[i]);
+		}
+		ok = checkInstance(model.get(), instance.get(), "SetCoefficient") && ok;
+
+		std::vector<unsigned> indices;
+		indices.push_back(1);
+		indices.push_back(k - 1);
+		instance->SetCoefficients(indices, statismo::Utils::generateNormalVector(indices.size(), stream));
+		ok = checkInstance(model.get(), instance.get(), "SetCoefficients(indices, values)") && ok;
+
+		unsigned ptId = numberOfPoints / 2;
+		statismo::ScalarType value = instance->GetValueAtPoint(ptId);
+		statismo::ScalarType expectedValue = model->DrawSampleAtPoint(instance->GetCoefficients(), ptId);
+		if (std::fabs(value - expectedValue) > 1e-5 * (1 + std::fabs(expectedValue))) {
+			std::cout << "GetValueAtPoint: " << value << " instead of " << expectedValue << std::endl;
+			ok = false;
+		}
+
+		instance->SetCoefficients(statismo::Utils::generateNormalVector(k, stream));
+		ok = checkInstance(model.get(), instance.get(), "SetCoefficients") && ok;
+
+		if (!ok) {
+			return EXIT_FAILURE;
+		}
+	}
+	catch (statismo::StatisticalModelException& e) {
+		std::cout << e.what() << std::endl;
+		return EXIT_FAILURE;
+	}
+	return EXIT_SUCCESS;
+}
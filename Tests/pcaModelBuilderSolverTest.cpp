@@ -0,0 +1,137 @@
+/*
+ * This file is part of the statismo library.
+ *
+ * Author: Marcel Luethi (marcel.luethi@unibas.ch)
+ *
+ * Copyright (c) 2011 University of Basel
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ *
+ * Neither the name of the project's author nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+ * TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS addINTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#include "TrivialVectorialRepresenter.h"
+#include "statismo/StatisticalModel.h"
+#include "statismo/PCAModelBuilder.h"
+#include "statismo/DataManager.h"
+
+#include <Eigen/SVD>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+
+typedef TrivialVectorialRepresenter RepresenterType;
+typedef statismo::StatisticalModel<RepresenterType> StatisticalModelType;
+typedef statismo::PCAModelBuilder<RepresenterType> ModelBuilderType;
+typedef statismo::DataManager<RepresenterType> DataManagerType;
+
+
+// builds a model with the given solver and compares its leading numberOfComponents components with the ones of the reference
+bool checkSolver(const DataManagerType* dataManager, const StatisticalModelType* reference, ModelBuilderType::SolverType solverType,
+		const char* name, unsigned numberOfComponents, double varianceTolerance, double cosineTolerance) {
+
+	statismo::shared_ptr<ModelBuilderType> modelBuilder(ModelBuilderType::Create(solverType));
+	if (solverType == ModelBuilderType::RANDOMIZED_SVD) {
+		modelBuilder->SetMaxNumberOfComponents(numberOfComponents);
+	}
+	statismo::shared_ptr<StatisticalModelType> model(modelBuilder->BuildNewModel(dataManager->GetSampleDataStructure(), 0, false));
+	if (model->GetNumberOfPrincipalComponents() < numberOfComponents) {
+		std::cout << name << ": only " << model->GetNumberOfPrincipalComponents() << " components" << std::endl;
+		return false;
+	}
+
+	Eigen::VectorXd referenceVariance = reference->GetPCAVarianceVector().topRows(numberOfComponents).cast<double>();
+	Eigen::VectorXd variance = model->GetPCAVarianceVector().topRows(numberOfComponents).cast<double>();
+	double maxVarianceError = ((variance - referenceVariance).array() / referenceVariance.array()).abs().maxCoeff();
+
+	// the cosine of the largest principal angle between the subspaces spanned by the components
+	Eigen::MatrixXd U = reference->GetOrthonormalPCABasisMatrix().leftCols(numberOfComponents).cast<double>();
+	Eigen::MatrixXd V = model->GetOrthonormalPCABasisMatrix().leftCols(numberOfComponents).cast<double>();
+	Eigen::JacobiSVD<Eigen::MatrixXd> svd(U.transpose() * V);
+	double minSubspaceCosine = svd.singularValues().minCoeff();
+
+	if (maxVarianceError > varianceTolerance || minSubspaceCosine < 1 - cosineTolerance) {
+		std::cout << name << ": relative variance error " << maxVarianceError << ", subspace cosine " << minSubspaceCosine << std::endl;
+		return false;
+	}
+	return true;
+}
+
+
+/**
+ * Compares the variances and the principal subspaces computed by the SELF_ADJOINT_EIGEN_SOLVER and the RANDOMIZED_SVD
+ * method of the PCAModelBuilder with the ones of the JACOBI_SVD, for fewer samples than variables (inner product matrix)
+ * and for more samples than variables (covariance matrix).
+ */
+int main(int argc, char* argv[]) {
+
+	const unsigned rank = 20;
+	const unsigned numberOfComponents = 5;
+	const unsigned sizes[2][2] = { { 300, 40 }, { 30, 100 } };
+
+	try {
+		bool ok = true;
+		for (unsigned c = 0; c < 2; c++) {
+			unsigned numberOfPoints = sizes[c][0];
+			unsigned numberOfSamples = sizes[c][1];
+
+			statismo::shared_ptr<RepresenterType> representer(RepresenterType::Create(numberOfPoints));
+			statismo::shared_ptr<DataManagerType> dataManager(DataManagerType::Create(representer.get()));
+
+			// the data has rank 20, with standard deviations decaying as 1/i
+			statismo::RandomStream stream(3);
+			statismo::MatrixType basis = statismo::Utils::generateNormalMatrix(numberOfPoints, rank, stream);
+			for (unsigned i = 0; i < numberOfSamples; i++) {
+				statismo::VectorType coefficients = statismo::Utils::generateNormalVector(rank, stream);
+				for (unsigned j = 0; j < rank; j++) {
+					coefficients(j) /= j + 1;
+				}
+				statismo::VectorType dataset = basis * coefficients;
+				dataManager->AddDataset(dataset, "dataset");
+			}
+
+			statismo::shared_ptr<ModelBuilderType> modelBuilder(ModelBuilderType::Create(ModelBuilderType::JACOBI_SVD));
+			statismo::shared_ptr<StatisticalModelType> reference(modelBuilder->BuildNewModel(dataManager->GetSampleDataStructure(), 0, false));
+
+			ok = checkSolver(dataManager.get(), reference.get(), ModelBuilderType::SELF_ADJOINT_EIGEN_SOLVER, "SELF_ADJOINT_EIGEN_SOLVER",
+					rank - 1, 1e-4, 1e-4) && ok;
+			ok = checkSolver(dataManager.get(), reference.get(), ModelBuilderType::RANDOMIZED_SVD, "RANDOMIZED_SVD",
+					numberOfComponents, 1e-3, 1e-3) && ok;
+		}
+
+		if (!ok) {
+			return EXIT_FAILURE;
+		}
+	}
+	catch (statismo::StatisticalModelException& e) {
+		std::cout << e.what() << std::endl;
+		return EXIT_FAILURE;
+	}
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,168 @@
+/*
+ * This file is part of the statismo library.
+ *
+ * Author: Marcel Luethi (marcel.luethi@unibas.ch)
+ *
+ * Copyright (c) 2011 University of Basel
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ *
+ * Neither the name of the project's author nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+ * TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS addINTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#include "TrivialVectorialRepresenter.h"
+#include "statismo/StatisticalModel.h"
+#include "statismo/PCAModelBuilder.h"
+#include "statismo/PosteriorSession.h"
+#include "statismo/DataManager.h"
+
+#include <cstdlib>
+#include <iostream>
+#include <map>
+
+typedef TrivialVectorialRepresenter RepresenterType;
+typedef statismo::StatisticalModel<RepresenterType> StatisticalModelType;
+typedef statismo::PosteriorSession<RepresenterType> PosteriorSessionType;
+typedef std::map<unsigned, RepresenterType::ValueType> PointValueMapType;
+
+
+// compares the coefficients of the session with the ones computed from scratch for the same point values
+bool checkSession(const StatisticalModelType* model, const PosteriorSessionType* session, const PointValueMapType& pointValues,
+		double noiseVariance, const char* step) {
+
+	StatisticalModelType::PointIdValueListType pointValueList;
+	for (PointValueMapType::const_iterator it = pointValues.begin(); it != pointValues.end(); ++it) {
+		pointValueList.push_back(StatisticalModelType::PointIdValuePairType(it->first, it->second));
+	}
+	statismo::VectorType expected = model->ComputeCoefficientsForPointIDValues(pointValueList, noiseVariance);
+	statismo::VectorType coefficients = session->GetCoefficients();
+
+	double error = (coefficients - expected).norm() / std::max(1.0f, expected.norm());
+	if (session->GetNumberOfPointValues() != pointValues.size() || error > 1e-3) {
+		std::cout << "the coefficients differ after " << step << " (" << pointValues.size() << " points, relative error " << error << ")" << std::endl;
+		return false;
+	}
+	return true;
+}
+
+
+// builds a model from random datasets, whose values are multiplied by the given scale
+StatisticalModelType* buildModel(const RepresenterType* representer, double scale, double noiseVariance) {
+
+	typedef statismo::PCAModelBuilder<RepresenterType> ModelBuilderType;
+	typedef statismo::DataManager<RepresenterType> DataManagerType;
+
+	statismo::shared_ptr<DataManagerType> dataManager(DataManagerType::Create(representer));
+	statismo::RandomStream stream(11);
+	for (unsigned i = 0; i < 20; i++) {
+		statismo::VectorType dataset = statismo::Utils::generateNormalVector(representer->GetDomain().GetNumberOfPoints(), stream) * scale;
+		dataManager->AddDataset(dataset, "dataset");
+	}
+
+	statismo::shared_ptr<ModelBuilderType> modelBuilder(ModelBuilderType::Create());
+	return modelBuilder->BuildNewModel(dataManager->GetSampleDataStructure(), noiseVariance);
+}
+
+
+/**
+ * Checks that the coefficients of a PosteriorSession agree with StatisticalModel::ComputeCoefficientsForPointIDValues
+ * after each AddPointValue, SetPointValue and RemovePointValue.
+ * The second part removes all the points from a session of a model with large values and (almost) no noise. Here the
+ * downdates of the factor fail, and the session has to refactorize.
+ */
+int main(int argc, char* argv[]) {
+
+	const unsigned numberOfPoints = 500;
+
+	try {
+		statismo::shared_ptr<RepresenterType> representer(RepresenterType::Create(numberOfPoints));
+		statismo::shared_ptr<StatisticalModelType> model(buildModel(representer.get(), 1, 0.01));
+
+		statismo::RandomStream stream(12);
+		statismo::VectorType target = model->DrawSampleVector(statismo::Utils::generateNormalVector(model->GetNumberOfPrincipalComponents(), stream));
+
+		bool ok = true;
+		for (unsigned n = 0; n < 2; n++) {
+			// the first pass uses the noise of the model only, the second one additional noise at the points
+			double noiseVariance = n * 0.5;
+			statismo::shared_ptr<PosteriorSessionType> session(PosteriorSessionType::Create(model.get(), noiseVariance));
+			PointValueMapType pointValues;
+
+			for (unsigned ptId = 0; ptId < numberOfPoints && ok; ptId += 10) {
+				pointValues[ptId] = target[ptId];
+				session->AddPointValue(ptId, target[ptId]);
+				ok = checkSession(model.get(), session.get(), pointValues, noiseVariance, "AddPointValue");
+			}
+
+			for (unsigned ptId = 0; ptId < numberOfPoints && ok; ptId += 30) {
+				pointValues[ptId] = target[ptId] + 1;
+				session->SetPointValue(ptId, pointValues[ptId]);
+				ok = checkSession(model.get(), session.get(), pointValues, noiseVariance, "SetPointValue");
+			}
+
+			for (unsigned ptId = 0; ptId < numberOfPoints - 20 && ok; ptId += 10) {
+				pointValues.erase(ptId);
+				session->RemovePointValue(ptId);
+				ok = checkSession(model.get(), session.get(), pointValues, noiseVariance, "RemovePointValue");
+			}
+
+			// a point that was removed can be added again
+			if (ok) {
+				pointValues[0] = target[0];
+				session->AddPointValue(0, target[0]);
+				ok = checkSession(model.get(), session.get(), pointValues, noiseVariance, "AddPointValue");
+			}
+		}
+
+		// without any point values, the coefficients are the ones of the mean
+		statismo::shared_ptr<StatisticalModelType> largeModel(buildModel(representer.get(), 1e6, 0));
+		statismo::shared_ptr<PosteriorSessionType> session(PosteriorSessionType::Create(largeModel.get()));
+		statismo::VectorType largeSample = largeModel->DrawSampleVector(statismo::Utils::generateNormalVector(largeModel->GetNumberOfPrincipalComponents(), stream));
+		for (unsigned ptId = 0; ptId < numberOfPoints; ptId += 10) {
+			session->AddPointValue(ptId, largeSample[ptId]);
+		}
+		for (unsigned ptId = 0; ptId < numberOfPoints; ptId += 10) {
+			session->RemovePointValue(ptId);
+		}
+		statismo::VectorType coefficients = session->GetCoefficients();
+		if (session->GetNumberOfPointValues() != 0 || !(coefficients.norm() < 1e-3)) {
+			std::cout << "the coefficients are not zero after removing all the points (norm " << coefficients.norm() << ")" << std::endl;
+			ok = false;
+		}
+
+		if (!ok) {
+			return EXIT_FAILURE;
+		}
+	}
+	catch (statismo::StatisticalModelException& e) {
+		std::cout << e.what() << std::endl;
+		return EXIT_FAILURE;
+	}
+	return EXIT_SUCCESS;
+}
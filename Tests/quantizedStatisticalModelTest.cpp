@@ -0,0 +1,219 @@
+/*
+ * This file is part of the statismo library.
+ *
+ * Author: Marcel Luethi (marcel.luethi@unibas.ch)
+ *
+ * Copyright (c) 2011 University of Basel
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ *
+ * Neither the name of the project's author nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+ * TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS addINTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#include "TrivialVectorialRepresenter.h"
+#include "statismo/StatisticalModel.h"
+#include "statismo/QuantizedStatisticalModel.h"
+#include "statismo/PCAModelBuilder.h"
+#include "statismo/DataManager.h"
+
+#include <Eigen/Eigenvalues>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <limits>
+
+typedef TrivialVectorialRepresenter RepresenterType;
+typedef statismo::StatisticalModel<RepresenterType> StatisticalModelType;
+typedef statismo::QuantizedStatisticalModel<RepresenterType> QuantizedModelType;
+
+
+// checks that the half precision conversion rounds to nearest, handles the subnormal numbers and clamps large values
+bool checkHalfPrecisionConversion() {
+
+	bool ok = true;
+
+	// every finite half precision number is converted to a float and back without change
+	for (unsigned h = 0; h < 0x10000; h++) {
+		if ((h & 0x7c00) == 0x7c00) {
+			continue;
+		}
+		boost::uint16_t roundTrip = QuantizedModelType::FloatToHalf(QuantizedModelType::HalfToFloat(h));
+		if (roundTrip != h) {
+			std::cout << "the half precision number " << h << " is converted to " << roundTrip << std::endl;
+			ok = false;
+		}
+	}
+
+	// some known values. 2^-24 is the smallest subnormal, 2^-14 the smallest normal and 65504 the largest number
+	const float values[] = { 1.0f, -2.0f, 0.5f, std::pow(2.0f, -24), std::pow(2.0f, -14), 65504.0f, -65504.0f };
+	const unsigned halves[] = { 0x3c00, 0xc000, 0x3800, 0x0001, 0x0400, 0x7bff, 0xfbff };
+	for (unsigned i = 0; i < sizeof(halves) / sizeof(halves[0]); i++) {
+		if (QuantizedModelType::FloatToHalf(values[i]) != halves[i]) {
+			std::cout << values[i] << " is converted to " << QuantizedModelType::FloatToHalf(values[i]) << std::endl;
+			ok = false;
+		}
+	}
+
+	// the numbers beyond the range, including those that round up to it, are clamped to the largest number
+	const float largeValues[] = { 65519.0f, 65520.0f, 65535.0f, 1e6f, std::numeric_limits<float>::max() };
+	for (unsigned i = 0; i < sizeof(largeValues) / sizeof(largeValues[0]); i++) {
+		if (QuantizedModelType::FloatToHalf(largeValues[i]) != 0x7bff || QuantizedModelType::FloatToHalf(-largeValues[i]) != 0xfbff) {
+			std::cout << largeValues[i] << " is not clamped to the largest half precision number" << std::endl;
+			ok = false;
+		}
+	}
+
+	// the relative rounding error of normal numbers is at most 2^-11, the absolute error of subnormal numbers at most 2^-25
+	statismo::RandomStream stream(1);
+	for (unsigned i = 0; i < 100000; i++) {
+		float f = std::ldexp(statismo::Utils::generateNormalScalar(stream), static_cast<int>(i % 40) - 30);
+		float error = std::fabs(QuantizedModelType::HalfToFloat(QuantizedModelType::FloatToHalf(f)) - f);
+		float bound = std::max(std::pow(2.0f, -11) * std::fabs(f), std::pow(2.0f, -25));
+		if (error > bound) {
+			std::cout << "the rounding error of " << f << " is " << error << std::endl;
+			ok = false;
+			break;
+		}
+	}
+	return ok;
+}
+
+
+// checks the quantized model against the model from which it was created
+bool checkQuantizedModel(const StatisticalModelType* model, const QuantizedModelType* quantizedModel, const char* name) {
+
+	unsigned k = model->GetNumberOfPrincipalComponents();
+	unsigned p = model->GetMeanVector().rows();
+	const double eps = std::numeric_limits<float>::epsilon();
+
+	// the quantized basis is recovered column by column. Adding and subtracting the mean introduces a rounding error
+	statismo::MatrixTypeDoublePrecision W = model->GetPCABasisMatrix().cast<double>();
+	statismo::VectorTypeDoublePrecision mean = model->GetMeanVector().cast<double>();
+	statismo::MatrixTypeDoublePrecision quantizedW(p, k);
+	for (unsigned j = 0; j < k; j++) {
+		quantizedW.col(j) = quantizedModel->DrawSampleVector(statismo::VectorType::Unit(k, j)).cast<double>() - mean;
+	}
+	statismo::MatrixTypeDoublePrecision roundingSlack = 2 * eps * (W.cwiseAbs().colwise() + mean.cwiseAbs());
+
+	// the error bounds hold for each entry of the basis
+	statismo::VectorTypeDoublePrecision bounds = quantizedModel->GetQuantizationErrorBounds().cast<double>();
+	statismo::MatrixTypeDoublePrecision basisError = (quantizedW - W).cwiseAbs() - roundingSlack;
+	for (unsigned j = 0; j < k; j++) {
+		if (basisError.col(j).maxCoeff() > bounds(j)) {
+			std::cout << name << ": the error of column " << j << " exceeds its bound " << bounds(j) << std::endl;
+			return false;
+		}
+	}
+
+	// the error of a sample is bounded by sum_j |alpha_j| e_j
+	statismo::RandomStream stream(2);
+	statismo::VectorType coefficients = statismo::Utils::generateNormalVector(k, stream);
+	statismo::VectorType sample = model->DrawSampleVector(coefficients);
+	statismo::VectorTypeDoublePrecision sampleError = (quantizedModel->DrawSampleVector(coefficients) - sample).cast<double>().cwiseAbs();
+	double sampleBound = coefficients.cast<double>().cwiseAbs().dot(bounds);
+	if ((sampleError - 4 * eps * sample.cast<double>().cwiseAbs()).maxCoeff() > sampleBound) {
+		std::cout << name << ": the sample error " << sampleError.maxCoeff() << " exceeds its bound " << sampleBound << std::endl;
+		return false;
+	}
+
+	// the coefficients are the exact ones of the quantized model, alpha' = M'^{-1} W'^T (s - mu), with M' = W'^T W' + sigma^2 I
+	statismo::VectorTypeDoublePrecision residual = sample.cast<double>() - mean;
+	statismo::MatrixTypeDoublePrecision quantizedM = quantizedW.transpose() * quantizedW;
+	quantizedM.diagonal().array() += model->GetNoiseVariance();
+	statismo::VectorTypeDoublePrecision expected = quantizedM.ldlt().solve(quantizedW.transpose() * residual);
+	statismo::VectorTypeDoublePrecision quantizedCoefficients = quantizedModel->ComputeCoefficientsForSampleVector(sample).cast<double>();
+	if ((quantizedCoefficients - expected).norm() > 1e-4 * expected.norm()) {
+		std::cout << name << ": the coefficients differ from the ones of the quantized basis" << std::endl;
+		return false;
+	}
+
+	// As M alpha = W^T r, the difference to the coefficients of the model is M'^{-1} ((W' - W)^T r - (M' - M) alpha). It is
+	// bounded using the norm E of W' - W, for which the error bounds give the upper bound sqrt(p sum_j e_j^2).
+	statismo::VectorTypeDoublePrecision alpha = model->ComputeCoefficientsForSampleVector(sample).cast<double>();
+	double E = std::sqrt(p * bounds.squaredNorm());
+	double normMInverse = 1.0 / Eigen::SelfAdjointEigenSolver<statismo::MatrixTypeDoublePrecision>(quantizedM).eigenvalues().minCoeff();
+	double coefficientBound = normMInverse * (E * residual.norm() + E * (W.norm() + quantizedW.norm()) * alpha.norm());
+	if ((quantizedCoefficients - alpha).norm() > coefficientBound + 1e-4 * alpha.norm()) {
+		std::cout << name << ": the coefficient error " << (quantizedCoefficients - alpha).norm() << " exceeds its bound " << coefficientBound << std::endl;
+		return false;
+	}
+	return true;
+}
+
+
+/**
+ * Tests the half precision conversion of the QuantizedStatisticalModel, and checks that the quantized models
+ * (created from a model, or loaded from its file) respect the error bounds given by GetQuantizationErrorBounds.
+ */
+int main(int argc, char* argv[]) {
+
+	typedef statismo::PCAModelBuilder<RepresenterType> ModelBuilderType;
+	typedef statismo::DataManager<RepresenterType> DataManagerType;
+
+	const unsigned numberOfPoints = 3000;
+	const unsigned numberOfSamples = 15;
+
+	bool ok = checkHalfPrecisionConversion();
+
+	try {
+		statismo::shared_ptr<RepresenterType> representer(RepresenterType::Create(numberOfPoints));
+		statismo::shared_ptr<DataManagerType> dataManager(DataManagerType::Create(representer.get()));
+
+		statismo::RandomStream stream(3);
+		for (unsigned i = 0; i < numberOfSamples; i++) {
+			statismo::VectorType dataset = statismo::Utils::generateNormalVector(numberOfPoints, stream) * 5;
+			dataset.array() += 10;
+			dataManager->AddDataset(dataset, "dataset");
+		}
+
+		statismo::shared_ptr<ModelBuilderType> modelBuilder(ModelBuilderType::Create());
+		statismo::shared_ptr<StatisticalModelType> model(modelBuilder->BuildNewModel(dataManager->GetSampleDataStructure(), 0.1));
+		model->Save("quantizedTestModel.h5");
+
+		const QuantizedModelType::QuantizationType types[] = { QuantizedModelType::QUANTIZATION_FP16, QuantizedModelType::QUANTIZATION_INT8 };
+		const char* names[] = { "FP16", "INT8" };
+		for (unsigned t = 0; t < 2; t++) {
+			statismo::shared_ptr<QuantizedModelType> quantizedModel(QuantizedModelType::Create(model.get(), types[t]));
+			ok = checkQuantizedModel(model.get(), quantizedModel.get(), names[t]) && ok;
+
+			// a model that is loaded block by block is identical to the one created from the model
+			statismo::shared_ptr<QuantizedModelType> loadedModel(QuantizedModelType::Load("quantizedTestModel.h5", types[t]));
+			statismo::VectorType coefficients = statismo::VectorType::Ones(model->GetNumberOfPrincipalComponents());
+			if (loadedModel->DrawSampleVector(coefficients) != quantizedModel->DrawSampleVector(coefficients)) {
+				std::cout << names[t] << ": the loaded model differs from the created one" << std::endl;
+				ok = false;
+			}
+		}
+	}
+	catch (statismo::StatisticalModelException& e) {
+		std::cout << e.what() << std::endl;
+		return EXIT_FAILURE;
+	}
+	return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,123 @@
+/*
+ * This file is part of the statismo library.
+ *
+ * Author: Marcel Luethi (marcel.luethi@unibas.ch)
+ *
+ * Copyright (c) 2011 University of Basel
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ *
+ * Neither the name of the project's author nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+ * TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS addINTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#include "TrivialVectorialRepresenter.h"
+#include "statismo/StatisticalModel.h"
+#include "statismo/PCAModelBuilder.h"
+#include "statismo/DataManager.h"
+
+#include <Eigen/Cholesky>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+
+typedef TrivialVectorialRepresenter RepresenterType;
+typedef statismo::StatisticalModel<RepresenterType> StatisticalModelType;
+
+
+/**
+ * Checks RobustlyComputeCoefficientsForDataset on a sample of the model, of which a few points are replaced by outliers.
+ * The coefficients must satisfy the equation (W^T Lambda W + I) alpha = W^T Lambda (S - mu) of the fixed point of the
+ * iterations, and be closer to the coefficients of the sample than the ones of ComputeCoefficientsForDataset.
+ */
+int main(int argc, char* argv[]) {
+
+	typedef statismo::PCAModelBuilder<RepresenterType> ModelBuilderType;
+	typedef statismo::DataManager<RepresenterType> DataManagerType;
+
+	const unsigned numberOfPoints = 200;
+	const unsigned numberOfSamples = 10;
+	const unsigned nu = 6;
+	const double sigma2 = 1;
+
+	try {
+		statismo::shared_ptr<RepresenterType> representer(RepresenterType::Create(numberOfPoints));
+		statismo::shared_ptr<DataManagerType> dataManager(DataManagerType::Create(representer.get()));
+
+		statismo::RandomStream stream(17);
+		for (unsigned i = 0; i < numberOfSamples; i++) {
+			statismo::VectorType dataset = statismo::Utils::generateNormalVector(numberOfPoints, stream) * 10;
+			dataManager->AddDataset(dataset, "dataset");
+		}
+
+		statismo::shared_ptr<ModelBuilderType> modelBuilder(ModelBuilderType::Create());
+		statismo::shared_ptr<StatisticalModelType> model(modelBuilder->BuildNewModel(dataManager->GetSampleDataStructure(), 0.1));
+
+		statismo::VectorType coefficients = statismo::Utils::generateNormalVector(model->GetNumberOfPrincipalComponents(), stream);
+		statismo::VectorType sample = model->DrawSampleVector(coefficients, stream);
+		for (unsigned i = 0; i < numberOfPoints; i += 20) {
+			sample[i] += 1000;
+		}
+
+		statismo::VectorType robustCoefficients = model->RobustlyComputeCoefficientsForDataset(sample, 100, nu, sigma2, 1e-8);
+		statismo::VectorType leastSquaresCoefficients = model->ComputeCoefficientsForDataset(sample);
+
+		// the residual of the fixed point equation, relative to its right hand side
+		statismo::MatrixTypeDoublePrecision W = model->GetPCABasisMatrix().cast<double>();
+		statismo::VectorTypeDoublePrecision alpha = robustCoefficients.cast<double>();
+		statismo::VectorTypeDoublePrecision y = (sample - model->GetMeanVector()).cast<double>();
+		statismo::VectorTypeDoublePrecision r = y - W * alpha;
+		statismo::VectorTypeDoublePrecision weights = (nu + 1.0) * (nu * sigma2 + r.array().square()).inverse().matrix();
+		statismo::MatrixTypeDoublePrecision A = W.transpose() * weights.asDiagonal() * W;
+		A.diagonal().array() += 1;
+		statismo::VectorTypeDoublePrecision b = W.transpose() * weights.asDiagonal() * y;
+		double fixedPointError = (A * alpha - b).norm() / b.norm();
+
+		double robustError = (robustCoefficients - coefficients).norm();
+		double leastSquaresError = (leastSquaresCoefficients - coefficients).norm();
+
+		bool ok = true;
+		if (fixedPointError > 1e-4) {
+			std::cout << "the coefficients do not satisfy the fixed point equation (relative residual " << fixedPointError << ")" << std::endl;
+			ok = false;
+		}
+		if (robustError > 0.1 * leastSquaresError) {
+			std::cout << "the robust coefficients are not better than the least squares ones (" << robustError << " vs " << leastSquaresError << ")" << std::endl;
+			ok = false;
+		}
+
+		if (!ok) {
+			return EXIT_FAILURE;
+		}
+	}
+	catch (statismo::StatisticalModelException& e) {
+		std::cout << e.what() << std::endl;
+		return EXIT_FAILURE;
+	}
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,179 @@
+/*
+ * This file is part of the statismo library.
+ *
+ * Author: Marcel Luethi (marcel.luethi@unibas.ch)
+ *
+ * Copyright (c) 2011 University of Basel
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ *
+ * Neither the name of the project's author nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+ * TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS addINTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#include "TrivialVectorialRepresenter.h"
+#include "statismo/StatisticalModel.h"
+#include "statismo/PCAModelBuilder.h"
+#include "statismo/StreamingPCAModelBuilder.h"
+#include "statismo/DataManager.h"
+
+#include <Eigen/SVD>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+
+typedef TrivialVectorialRepresenter RepresenterType;
+typedef statismo::StatisticalModel<RepresenterType> StatisticalModelType;
+typedef statismo::StreamingPCAModelBuilder<RepresenterType> StreamingModelBuilderType;
+
+
+// compares the leading numberOfComponents components of the model with the ones of the reference model. Returns the largest
+// relative error of the variances and the cosine of the largest principal angle between the spanned subspaces.
+void compareModels(const StatisticalModelType* reference, const StatisticalModelType* model, unsigned numberOfComponents,
+		double& maxVarianceError, double& minSubspaceCosine) {
+
+	Eigen::VectorXd referenceVariance = reference->GetPCAVarianceVector().topRows(numberOfComponents).cast<double>();
+	Eigen::VectorXd variance = model->GetPCAVarianceVector().topRows(numberOfComponents).cast<double>();
+	maxVarianceError = ((variance - referenceVariance).array() / referenceVariance.array()).abs().maxCoeff();
+
+	Eigen::MatrixXd U = reference->GetOrthonormalPCABasisMatrix().leftCols(numberOfComponents).cast<double>();
+	Eigen::MatrixXd V = model->GetOrthonormalPCABasisMatrix().leftCols(numberOfComponents).cast<double>();
+	Eigen::JacobiSVD<Eigen::MatrixXd> svd(U.transpose() * V);
+	minSubspaceCosine = svd.singularValues().minCoeff();
+}
+
+
+// builds a model with the streaming builder from the given data manager file and checks it against the reference
+bool checkStreamingModel(const StatisticalModelType* reference, const char* name, StreamingModelBuilderType* builder,
+		unsigned numberOfComponents, double varianceTolerance, double cosineTolerance) {
+
+	builder->BuildNewModelFromDataManagerFile("streamingTestData.h5", "streamingTestModel.h5", 0);
+	statismo::shared_ptr<StatisticalModelType> model(StatisticalModelType::Load("streamingTestModel.h5"));
+
+	if (model->GetNumberOfPrincipalComponents() < numberOfComponents) {
+		std::cout << name << ": only " << model->GetNumberOfPrincipalComponents() << " components" << std::endl;
+		return false;
+	}
+	if ((model->GetMeanVector() - reference->GetMeanVector()).norm() > 1e-4 * reference->GetMeanVector().norm()) {
+		std::cout << name << ": the mean differs" << std::endl;
+		return false;
+	}
+
+	double maxVarianceError, minSubspaceCosine;
+	compareModels(reference, model.get(), numberOfComponents, maxVarianceError, minSubspaceCosine);
+	std::cout << name << ": relative variance error " << maxVarianceError << ", subspace cosine " << minSubspaceCosine << std::endl;
+	return maxVarianceError < varianceTolerance && minSubspaceCosine > 1 - cosineTolerance;
+}
+
+
+/**
+ * Compares the models built by the StreamingPCAModelBuilder (with the GRAM_MATRIX and the SKETCH method) with the model
+ * built by the PCAModelBuilder, for the variances and the subspace spanned by the leading components.
+ */
+int main(int argc, char* argv[]) {
+
+	typedef statismo::PCAModelBuilder<RepresenterType> ModelBuilderType;
+	typedef statismo::DataManager<RepresenterType> DataManagerType;
+
+	const unsigned numberOfPoints = 2000;
+	const unsigned numberOfSamples = 100;
+	const unsigned rank = 50;
+	const unsigned numberOfComponents = 5;
+
+	try {
+		statismo::shared_ptr<RepresenterType> representer(RepresenterType::Create(numberOfPoints));
+		statismo::shared_ptr<DataManagerType> dataManager(DataManagerType::Create(representer.get()));
+
+		// the data has rank 50, with standard deviations decaying as 1/i^2
+		statismo::RandomStream stream(7);
+		statismo::MatrixType basis = statismo::Utils::generateNormalMatrix(numberOfPoints, rank, stream);
+		statismo::VectorType mean = statismo::VectorType::Constant(numberOfPoints, 100);
+		for (unsigned i = 0; i < numberOfSamples; i++) {
+			statismo::VectorType coefficients = statismo::Utils::generateNormalMatrix(rank, 1, stream).col(0);
+			for (unsigned j = 0; j < rank; j++) {
+				coefficients(j) /= (j + 1) * (j + 1);
+			}
+			statismo::VectorType dataset = mean + basis * coefficients;
+			dataManager->AddDataset(dataset, "dataset");
+		}
+		dataManager->Save("streamingTestData.h5");
+
+		statismo::shared_ptr<ModelBuilderType> pcaModelBuilder(ModelBuilderType::Create(ModelBuilderType::SELF_ADJOINT_EIGEN_SOLVER));
+		statismo::shared_ptr<StatisticalModelType> reference(pcaModelBuilder->BuildNewModel(dataManager->GetSampleDataStructure(), 0, false));
+
+		bool ok = true;
+
+		// the Gram matrix method is exact. A small memory limit makes sure that the data is read in several blocks
+		statismo::shared_ptr<StreamingModelBuilderType> gramBuilder(StreamingModelBuilderType::Create(StreamingModelBuilderType::GRAM_MATRIX));
+		gramBuilder->SetMemoryLimitInMB(0.5);
+		ok = checkStreamingModel(reference.get(), "GRAM_MATRIX", gramBuilder.get(), numberOfComponents, 1e-4, 1e-6) && ok;
+
+		// the sketch is approximate for the default sketch size, and exact if the sketch captures the complete rank
+		statismo::shared_ptr<StreamingModelBuilderType> sketchBuilder(StreamingModelBuilderType::Create(StreamingModelBuilderType::SKETCH));
+		sketchBuilder->SetMemoryLimitInMB(0.5);
+		sketchBuilder->SetMaxNumberOfComponents(numberOfComponents);
+		ok = checkStreamingModel(reference.get(), "SKETCH", sketchBuilder.get(), numberOfComponents, 0.05, 1e-2) && ok;
+
+		sketchBuilder->SetSketchSize(rank);
+		ok = checkStreamingModel(reference.get(), "SKETCH (full rank)", sketchBuilder.get(), numberOfComponents, 1e-3, 1e-5) && ok;
+
+		// with the variance retained, the same number of components is kept as by the PCAModelBuilder
+		pcaModelBuilder->SetVarianceRetained(0.9);
+		gramBuilder->SetVarianceRetained(0.9);
+		statismo::shared_ptr<StatisticalModelType> reducedReference(pcaModelBuilder->BuildNewModel(dataManager->GetSampleDataStructure(), 0, false));
+		gramBuilder->BuildNewModelFromDataManagerFile("streamingTestData.h5", "streamingTestModel.h5", 0);
+		statismo::shared_ptr<StatisticalModelType> reducedModel(StatisticalModelType::Load("streamingTestModel.h5"));
+		if (reducedModel->GetNumberOfPrincipalComponents() != reducedReference->GetNumberOfPrincipalComponents()) {
+			std::cout << "GRAM_MATRIX with variance retained: " << reducedModel->GetNumberOfPrincipalComponents() << " instead of "
+					<< reducedReference->GetNumberOfPrincipalComponents() << " components" << std::endl;
+			ok = false;
+		}
+
+		// if the build fails (here, as all the eigenvalues are below the noise variance), no model or scratch file is left behind
+		try {
+			sketchBuilder->BuildNewModelFromDataManagerFile("streamingTestData.h5", "streamingTestFailedModel.h5", 1e10);
+			std::cout << "the build with a too large noise variance did not fail" << std::endl;
+			ok = false;
+		}
+		catch (statismo::StatisticalModelException&) {
+			if (std::ifstream("streamingTestFailedModel.h5") || std::ifstream("streamingTestFailedModel.h5.sketch")) {
+				std::cout << "the files of the failed build were not removed" << std::endl;
+				ok = false;
+			}
+		}
+
+		if (!ok) {
+			return EXIT_FAILURE;
+		}
+	}
+	catch (statismo::StatisticalModelException& e) {
+		std::cout << e.what() << std::endl;
+		return EXIT_FAILURE;
+	}
+	return EXIT_SUCCESS;
+}
@@ -49,6 +49,21 @@
 
 #include <Eigen/Dense>
 
+// The reference counted pointer that is used to share immutable data between objects.
+// The shared_ptr of the bundled boost version predates C++11 and cannot be copied when compiled as C++11.
+// We therefore use the standard version whenever it is available.
+#if __cplusplus >= 201103L || (defined(_MSC_VER) && _MSC_VER >= 1600)
+#include <memory>
+namespace statismo {
+using std::shared_ptr;
+}
+#else
+#include <boost/shared_ptr.hpp>
+namespace statismo {
+using boost::shared_ptr;
+}
+#endif
+
 
 
 namespace statismo {
@@ -68,6 +83,15 @@ typedef Eigen::Matrix<ScalarType, 1 , Eigen::Dynamic> RowVectorType;
 typedef Eigen::Matrix<ScalarType, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor> MatrixType;
 typedef Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor> MatrixTypeDoublePrecision;
 
+/// A read only view of the leading columns of a matrix of type MatrixType. The rows of the view are
+/// contiguous, but the distance between two rows (the outer stride) can be larger than the number of columns.
+typedef Eigen::Map<const MatrixType, Eigen::Unaligned, Eigen::OuterStride<> > ConstMatrixViewType;
+
+/// A read only view of a block of a matrix of type MatrixType, whose columns are scaled by the entries of a vector.
+/// The scaling is applied whenever a coefficient is accessed, i.e. the matrix is never copied.
+/// (A block is used rather than a ConstMatrixViewType, as Eigen nests the latter by reference)
+typedef Eigen::DiagonalProduct<Eigen::Block<const MatrixType>, Eigen::DiagonalWrapper<const VectorType>, Eigen::OnTheRight> ConstScaledMatrixViewType;
+
 /// Diagonal matrix type used throughout the library
 typedef Eigen::DiagonalMatrix<ScalarType, Eigen::Dynamic> DiagMatrixType;
 typedef Eigen::DiagonalMatrix<double, Eigen::Dynamic> DiagMatrixTypeDoublePrecision;
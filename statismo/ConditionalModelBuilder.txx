@@ -41,6 +41,7 @@
 
 #include <Eigen/SVD>
 #include "PCAModelBuilder.h"
+#include "MixedPrecision.h"
 
 namespace statismo {
 
@@ -165,22 +166,26 @@ ConditionalModelBuilder<Representer>::BuildNewModel(const SampleDataStructureLis
 		assert(mu.rows() == nPCAComponents + nCondVariables);
 
 		MatrixType A0 = A.rowwise() - mu.transpose(); //
-		MatrixType cov = 1.0 / (nSamples-1) * A0.transpose() *  A0;
+		// the covariance and the conditioning are computed in double precision, as Sxx is often badly conditioned
+		MatrixTypeDoublePrecision cov = MixedPrecision::TransposeTimesSelf(A0) / (nSamples-1);
 
 		assert(cov.rows() == cov.cols());
 		assert(cov.rows() == pcaModel->GetNumberOfPrincipalComponents() + nCondVariables);
 
 		// extract the submatrices involving the conditionals x
 		// note that since the matrix is symmetric, Sbx = Sxb.transpose(), hence we only store one
-		MatrixType Sbx = cov.topRightCorner(nPCAComponents, nCondVariables);
-		MatrixType Sxx = cov.bottomRightCorner(nCondVariables, nCondVariables);
-		MatrixType Sbb = cov.topLeftCorner(nPCAComponents, nPCAComponents);
+		MatrixTypeDoublePrecision Sbx = cov.topRightCorner(nPCAComponents, nCondVariables);
+		MatrixTypeDoublePrecision Sxx = cov.bottomRightCorner(nCondVariables, nCondVariables);
+		MatrixTypeDoublePrecision Sbb = cov.topLeftCorner(nPCAComponents, nPCAComponents);
+		MatrixTypeDoublePrecision SxxInv = Sxx.inverse();
 
 		// compute the conditional mean
-		VectorType condMean = mu.topRows(nPCAComponents) + Sbx * Sxx.inverse() * (x0 - mu.bottomRows(nCondVariables));
+		VectorType x0Centered = x0 - mu.bottomRows(nCondVariables);
+		VectorTypeDoublePrecision condMeanDouble = Sbx * SxxInv * x0Centered.cast<double>();
+		VectorType condMean = mu.topRows(nPCAComponents) + condMeanDouble.cast<ScalarType>();
 
 		// compute the conditional covariance
-		MatrixType condCov = Sbb - Sbx * Sxx.inverse() * Sbx.transpose();
+		MatrixTypeDoublePrecision condCov = Sbb - Sbx * SxxInv * Sbx.transpose();
 		
 		// get the sample mean corresponding the the conditional given mean of the parameter vectors
 		VectorType condMeanSample = pcaModel->GetRepresenter()->SampleToSampleVector(pcaModel->DrawSample(condMean));
@@ -194,7 +199,7 @@ ConditionalModelBuilder<Representer>::BuildNewModel(const SampleDataStructureLis
 		VectorTypeDoublePrecision pcaSdev = pcaVariance.cast<double>().array().sqrt();
 
 		typedef Eigen::JacobiSVD<MatrixTypeDoublePrecision> SVDType;
-		MatrixTypeDoublePrecision innerMatrix = pcaSdev.asDiagonal() * condCov.cast<double>() * pcaSdev.asDiagonal();
+		MatrixTypeDoublePrecision innerMatrix = pcaSdev.asDiagonal() * condCov * pcaSdev.asDiagonal();
 		SVDType svd(innerMatrix, Eigen::ComputeThinU);
   	VectorType singularValues = svd.singularValues().cast<ScalarType>();
 
@@ -212,7 +217,9 @@ ConditionalModelBuilder<Representer>::BuildNewModel(const SampleDataStructureLis
     unsigned numComponentsToKeep = std::min<unsigned>( numComponentsToReachPrescribedVariance, singularValues.size() );
 
   	VectorType newPCAVariance = singularValues.topRows(numComponentsToKeep);
-  	MatrixType newPCABasisMatrix = (pcaModel->GetOrthonormalPCABasisMatrix() * svd.matrixU().cast<ScalarType>()).topLeftCorner(X.cols(), numComponentsToKeep);
+  	// U Uhat = W D^{-1/2} Uhat, i.e. the scaling is applied to the small matrix Uhat, rather than to the basis
+  	MatrixTypeDoublePrecision scaledUhat = pcaSdev.cwiseInverse().asDiagonal() * svd.matrixU().leftCols(numComponentsToKeep);
+  	MatrixType newPCABasisMatrix = pcaModel->GetPCABasisMatrixView().topRows(X.cols()) * scaledUhat.cast<ScalarType>();
 
 		StatisticalModelType* model = StatisticalModelType::Create(pcaModel->GetRepresenter(), condMeanSample, newPCABasisMatrix, newPCAVariance, noiseVariance);
 
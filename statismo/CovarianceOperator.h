@@ -0,0 +1,137 @@
+/*
+ * This file is part of the statismo library.
+ *
+ * Author: Marcel Luethi (marcel.luethi@unibas.ch)
+ *
+ * Copyright (c) 2011 University of Basel
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ *
+ * Neither the name of the project's author nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+ * TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS addINTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#ifndef __COVARIANCEOPERATOR_H_
+#define __COVARIANCEOPERATOR_H_
+
+#include "Config.h"
+#include "StatisticalModel.h"
+#include "CommonTypes.h"
+#include <vector>
+
+namespace statismo {
+
+
+/**
+ * \brief Implicit representation of the covariance matrix of a StatisticalModel.
+ *
+ * The covariance matrix of a model defined on \f$n\f$ points in \f$d\f$ dimensions is the
+ * \f$p \times p\f$ (\f$p = nd\f$) matrix \f$\Sigma = W W^T + \sigma^2 I\f$, where \f$W\f$ is the
+ * \f$p \times k\f$ PCA basis. For large models this matrix cannot be stored (see StatisticalModel::GetCovarianceMatrix).
+ * This class provides the typical operations on \f$\Sigma\f$ by working directly with the low rank factors.
+ * All the operations are at most \f$O(pk)\f$.
+ *
+ * \warning The operator only references the model. The model must not be deleted as long as the operator is in use.
+ */
+template <typename Representer>
+class CovarianceOperator {
+public:
+
+	typedef StatisticalModel<Representer> StatisticalModelType;
+	typedef typename StatisticalModelType::PointIdListType PointIdListType;
+
+	/**
+	 * Factory method that creates a new covariance operator for the given model
+	 */
+	static CovarianceOperator* Create(const StatisticalModelType* model) {
+		return new CovarianceOperator(model);
+	}
+
+	/**
+	 * Destroy the object.
+	 * The same effect can be achieved by deleting the object in the usual
+	 * way using the c++ delete keyword.
+	 */
+	void Delete() const { delete this; }
+
+	/**
+	 * Destructor
+	 */
+	virtual ~CovarianceOperator() {}
+
+	/**
+	 * Returns the product \f$\Sigma v\f$ of the covariance matrix with the given vector.
+	 * \param v A vector with the same dimensionality as the sample vectors of the model
+	 */
+	VectorType Apply(const VectorType& v) const;
+
+	/**
+	 * Returns the block of the covariance matrix, whose rows correspond to the given row points and whose
+	 * columns correspond to the given column points. The d-th component of the i-th point is found at
+	 * row (column) i * Representer::GetDimensions() + d.
+	 *
+	 * \param rowPointIds The ids of the points defining the rows of the block
+	 * \param colPointIds The ids of the points defining the columns of the block
+	 */
+	MatrixType GetBlock(const PointIdListType& rowPointIds, const PointIdListType& colPointIds) const;
+
+	/**
+	 * Returns the diagonal of the covariance matrix, i.e. the variance of each entry of the sample vector.
+	 */
+	VectorType GetDiagonal() const;
+
+	/**
+	 * Returns for each point of the model the marginal variance at this point, defined as the trace of
+	 * the d x d covariance matrix at the point (i.e. the sum of the variances of the d components).
+	 * The i-th entry of the vector holds the variance of the point with id i.
+	 */
+	VectorType GetPointVariances() const;
+
+	/**
+	 * Returns the d x d covariance matrices at all the points of the model, computed in a single pass over the PCA basis.
+	 * The rows i * d to (i+1) * d - 1 of the returned (n * d) x d matrix hold the covariance matrix at the point with id i.
+	 */
+	MatrixType GetPointCovariances() const;
+
+private:
+
+	CovarianceOperator(const StatisticalModelType* model) : m_model(model) {}
+
+	// to prevent use
+	CovarianceOperator(const CovarianceOperator& orig);
+	CovarianceOperator& operator=(const CovarianceOperator& rhs);
+
+	const StatisticalModelType* m_model;
+};
+
+
+} // namespace statismo
+
+#include "CovarianceOperator.txx"
+
+#endif /* __COVARIANCEOPERATOR_H_ */
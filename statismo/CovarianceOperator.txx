@@ -0,0 +1,149 @@
+/*
+ * This file is part of the statismo library.
+ *
+ * Author: Marcel Luethi (marcel.luethi@unibas.ch)
+ *
+ * Copyright (c) 2011 University of Basel
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ *
+ * Neither the name of the project's author nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+ * TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS addINTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#include "CovarianceOperator.h"
+#include "Exceptions.h"
+#include "MixedPrecision.h"
+
+namespace statismo {
+
+
+template <typename Representer>
+VectorType
+CovarianceOperator<Representer>::Apply(const VectorType& v) const {
+
+	ConstMatrixViewType W = m_model->GetPCABasisMatrixView();
+	if (v.rows() != W.rows()) {
+		throw StatisticalModelException("The vector provided to CovarianceOperator::Apply does not match the model dimensions!");
+	}
+
+	// (W W^T + sigma^2 I) v is evaluated as W (W^T v) + sigma^2 v, which never forms a p x p matrix
+	VectorType WTv = MixedPrecision::TransposeTimes(W, v).cast<ScalarType>();
+	VectorType result = v * m_model->GetNoiseVariance();
+	result.noalias() += W * WTv;
+	return result;
+}
+
+
+template <typename Representer>
+MatrixType
+CovarianceOperator<Representer>::GetBlock(const PointIdListType& rowPointIds, const PointIdListType& colPointIds) const {
+
+	std::vector<unsigned> rowIndices = m_model->MapPointIdsToInternalIndices(rowPointIds);
+	std::vector<unsigned> colIndices = m_model->MapPointIdsToInternalIndices(colPointIds);
+
+	ConstMatrixViewType W = m_model->GetPCABasisMatrixView();
+
+	MatrixType Wr(rowIndices.size(), W.cols());
+	for (unsigned i = 0; i < rowIndices.size(); i++) {
+		Wr.row(i) = W.row(rowIndices[i]);
+	}
+	MatrixType Wc(colIndices.size(), W.cols());
+	for (unsigned j = 0; j < colIndices.size(); j++) {
+		Wc.row(j) = W.row(colIndices[j]);
+	}
+
+	MatrixType block = Wr * Wc.transpose();
+
+	// the noise term only contributes where a row and a column refer to the same entry of the sample vector
+	for (unsigned i = 0; i < rowIndices.size(); i++) {
+		for (unsigned j = 0; j < colIndices.size(); j++) {
+			if (rowIndices[i] == colIndices[j]) {
+				block(i, j) += m_model->GetNoiseVariance();
+			}
+		}
+	}
+	return block;
+}
+
+
+template <typename Representer>
+VectorType
+CovarianceOperator<Representer>::GetDiagonal() const {
+	VectorType diagonal = m_model->GetPCABasisMatrixView().rowwise().squaredNorm();
+	diagonal.array() += m_model->GetNoiseVariance();
+	return diagonal;
+}
+
+
+template <typename Representer>
+VectorType
+CovarianceOperator<Representer>::GetPointVariances() const {
+
+	const unsigned dim = RepresenterTraits<Representer>::GetDimensions();
+	unsigned numberOfPoints = m_model->GetDomain().GetNumberOfPoints();
+
+	VectorType diagonal = GetDiagonal();
+
+	VectorType pointVariances = VectorType::Zero(numberOfPoints);
+	for (unsigned ptId = 0; ptId < numberOfPoints; ptId++) {
+		for (unsigned d = 0; d < dim; d++) {
+			pointVariances[ptId] += diagonal[Representer::MapPointIdToInternalIdx(ptId, d)];
+		}
+	}
+	return pointVariances;
+}
+
+
+template <typename Representer>
+MatrixType
+CovarianceOperator<Representer>::GetPointCovariances() const {
+
+	const unsigned dim = RepresenterTraits<Representer>::GetDimensions();
+	unsigned numberOfPoints = m_model->GetDomain().GetNumberOfPoints();
+
+	ConstMatrixViewType W = m_model->GetPCABasisMatrixView();
+
+	MatrixType pointCovariances(numberOfPoints * dim, dim);
+	for (unsigned ptId = 0; ptId < numberOfPoints; ptId++) {
+		for (unsigned i = 0; i < dim; i++) {
+			unsigned idxi = Representer::MapPointIdToInternalIdx(ptId, i);
+			for (unsigned j = i; j < dim; j++) {
+				unsigned idxj = Representer::MapPointIdToInternalIdx(ptId, j);
+				ScalarType c = W.row(idxi).dot(W.row(idxj));
+				pointCovariances(ptId * dim + i, j) = c;
+				pointCovariances(ptId * dim + j, i) = c;
+			}
+			pointCovariances(ptId * dim + i, i) += m_model->GetNoiseVariance();
+		}
+	}
+	return pointCovariances;
+}
+
+
+} // namespace statismo
@@ -183,7 +183,8 @@ public:
 	 * This method has to be called before cross validation can be started.
 	 *
 	 * \param nFolds The number of folds used in the crossvalidation
-	 * \param randomize If true, the data will be randomly assigned to the nfolds, otherwise the order with which it was added is preserved
+	 * \param randomize If true, the data will be randomly assigned to the nfolds, otherwise the order with which it was added is preserved.
+	 * The random numbers are taken from the default random stream (see Utils::SetRandomSeed).
 	 */
 	CrossValidationFoldListType GetCrossValidationFolds(unsigned nFolds, bool randomize = true) const;
 
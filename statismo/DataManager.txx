@@ -206,10 +206,9 @@ DataManager<Representer>::GetCrossValidationFolds(unsigned nFolds, bool randomiz
 		batchAssignment[i] = std::min(i / nElemsPerFold, nFolds);
 	}
 
-	// randomly shuffle the vector
-	srand (time(0));
+	// randomly shuffle the vector. We use the default random stream, such that the folds are reproducible after Utils::SetRandomSeed
 	if (randomize) {
-		std::random_shuffle ( batchAssignment.begin(), batchAssignment.end());
+		Utils::randomShuffle(batchAssignment.begin(), batchAssignment.end());
 	}
 
 	// now we create the folds
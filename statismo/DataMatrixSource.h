@@ -0,0 +1,115 @@
+/*
+ * This file is part of the statismo library.
+ *
+ * Author: Marcel Luethi (marcel.luethi@unibas.ch)
+ *
+ * Copyright (c) 2011 University of Basel
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ *
+ * Neither the name of the project's author nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+ * TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS addINTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#ifndef __DATAMATRIXSOURCE_H_
+#define __DATAMATRIXSOURCE_H_
+
+#include "CommonTypes.h"
+#include <vector>
+#include <cassert>
+
+namespace statismo {
+
+/**
+ * \brief Access to the centered data matrix of a PCA by blocks of rows or columns - internal use only.
+ *
+ * The rows of the data matrix X are the sample vectors. The PCA computations only need the centered data matrix
+ * \f$X_0 = X - 1 \mu^T\f$ block by block. Accessing it through this interface avoids holding a centered copy of
+ * the complete data matrix. The blocks are returned in double precision, such that all the products are accumulated in
+ * double precision (c.f. MixedPrecision).
+ */
+class DataMatrixSource {
+public:
+	virtual ~DataMatrixSource() {}
+
+	/// the number of samples n
+	virtual unsigned GetNumberOfRows() const = 0;
+
+	/// the dimension p of the sample vectors
+	virtual unsigned GetNumberOfColumns() const = 0;
+
+	/// copies the rows firstRow, ..., firstRow + nRows - 1 of the centered data matrix into block
+	virtual void GetCenteredRows(unsigned firstRow, unsigned nRows, MatrixTypeDoublePrecision& block) const = 0;
+
+	/// copies the columns firstCol, ..., firstCol + nCols - 1 of the centered data matrix into block
+	virtual void GetCenteredColumns(unsigned firstCol, unsigned nCols, MatrixTypeDoublePrecision& block) const = 0;
+};
+
+
+/**
+ * \brief A data matrix, whose rows are given by sample vectors held in memory.
+ *
+ * The sample vectors are neither copied nor modified. They are centered on the fly, whenever a block is accessed.
+ * The vectors must therefore exist as long as the source is used.
+ */
+class SampleVectorListSource : public DataMatrixSource {
+public:
+	SampleVectorListSource(const std::vector<const VectorType*>& samples, const VectorType& mean)
+	: m_samples(samples), m_mean(mean.cast<double>())
+	{
+		for (unsigned i = 0; i < m_samples.size(); i++) {
+			assert(m_samples[i]->rows() == m_mean.rows());
+		}
+	}
+
+	unsigned GetNumberOfRows() const { return m_samples.size(); }
+	unsigned GetNumberOfColumns() const { return m_mean.rows(); }
+
+	void GetCenteredRows(unsigned firstRow, unsigned nRows, MatrixTypeDoublePrecision& block) const {
+		block.resize(nRows, m_mean.rows());
+		for (unsigned i = 0; i < nRows; i++) {
+			block.row(i) = (m_samples[firstRow + i]->cast<double>() - m_mean).transpose();
+		}
+	}
+
+	void GetCenteredColumns(unsigned firstCol, unsigned nCols, MatrixTypeDoublePrecision& block) const {
+		block.resize(m_samples.size(), nCols);
+		for (unsigned i = 0; i < m_samples.size(); i++) {
+			block.row(i) = (m_samples[i]->segment(firstCol, nCols).cast<double>() - m_mean.segment(firstCol, nCols)).transpose();
+		}
+	}
+
+private:
+	std::vector<const VectorType*> m_samples;
+	VectorTypeDoublePrecision m_mean;
+};
+
+
+} // namespace statismo
+
+#endif /* __DATAMATRIXSOURCE_H_ */
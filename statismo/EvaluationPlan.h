@@ -0,0 +1,190 @@
+/*
+ * This file is part of the statismo library.
+ *
+ * Author: Marcel Luethi (marcel.luethi@unibas.ch)
+ *
+ * Copyright (c) 2011 University of Basel
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ *
+ * Neither the name of the project's author nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+ * TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS addINTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#ifndef __EVALUATIONPLAN_H_
+#define __EVALUATIONPLAN_H_
+
+#include "Config.h"
+#include "StatisticalModel.h"
+#include "CommonTypes.h"
+#include <vector>
+
+namespace statismo {
+
+
+/**
+ * \brief Precompiled evaluation of a StatisticalModel on a fixed subset of its points.
+ *
+ * Fitting algorithms often evaluate the model on the same set of points in every iteration.
+ * Calling StatisticalModel::DrawSampleAtPoint, StatisticalModel::GetJacobian or StatisticalModel::GetCovarianceAtPoint
+ * for each point resolves the point ids and copies the corresponding rows of the PCA basis again and again.
+ * An EvaluationPlan does this work only once: It stores the point ids together with a packed copy of the
+ * rows of the mean and the PCA basis that belong to these points.
+ * All the queries are then simple matrix operations on this (small) submodel.
+ *
+ * The values of the points are stored in their vectorial representation
+ * (see Representer::PointSampleToPointSampleVector). The d-th component of the i-th point is found at
+ * position i * Representer::GetDimensions() + d.
+ *
+ * The plan can also compute the coefficients for given values at its points (see StatisticalModel::ComputeCoefficientsForPointIDValues).
+ * The linear system is factorized once when the plan is created, such that only a forward and backward substitution
+ * is needed when the values change (e.g. while a landmark is moved interactively).
+ *
+ * The plan is the intended entry point whenever the model is queried repeatedly on the same points.
+ * StatisticalModel::ComputeCoefficientsForPointIDValues and ComputeCoefficientsForPointValues are convenience methods,
+ * which build a new plan (and thus copy the rows and factorize the system) on every call.
+ *
+ * \warning The plan holds a copy of the data. Changes to the model after the plan has been created are not reflected.
+ */
+template <typename Representer>
+class EvaluationPlan {
+public:
+
+	typedef StatisticalModel<Representer> StatisticalModelType;
+	typedef typename Representer::PointType PointType;
+	typedef typename StatisticalModelType::PointIdListType PointIdListType;
+	typedef std::vector<PointType> PointListType;
+
+	/**
+	 * Factory method that creates a new plan for the given point ids
+	 * \param model The statistical model
+	 * \param pointIds The ids of the points on which the model is evaluated
+	 * \param pointValueNoiseVariance The variance of the (gaussian) noise assumed on values provided to ComputeCoefficientsForValues
+	 * \throws StatisticalModelException if the system for the coefficients is singular, i.e. if the model has no noise,
+	 * pointValueNoiseVariance is zero and the points do not determine the coefficients
+	 */
+	static EvaluationPlan* Create(const StatisticalModelType* model, const PointIdListType& pointIds, double pointValueNoiseVariance = 0.0) {
+		return new EvaluationPlan(model, pointIds, pointValueNoiseVariance);
+	}
+
+	/**
+	 * Factory method that creates a new plan for the given points.
+	 * The points are mapped to the corresponding point ids by the representer.
+	 * \param model The statistical model
+	 * \param points The points on which the model is evaluated
+	 * \param pointValueNoiseVariance The variance of the (gaussian) noise assumed on values provided to ComputeCoefficientsForValues
+	 */
+	static EvaluationPlan* CreateFromPoints(const StatisticalModelType* model, const PointListType& points, double pointValueNoiseVariance = 0.0);
+
+	/**
+	 * Destroy the object.
+	 * The same effect can be achieved by deleting the object in the usual
+	 * way using the c++ delete keyword.
+	 */
+	void Delete() const { delete this; }
+
+	/**
+	 * Destructor
+	 */
+	virtual ~EvaluationPlan() {}
+
+	/**
+	 * \return The point ids for which the plan was built
+	 */
+	const PointIdListType& GetPointIds() const { return m_pointIds; }
+
+	/**
+	 * \return The number of points for which the plan was built
+	 */
+	unsigned GetNumberOfPoints() const { return m_pointIds.size(); }
+
+	/**
+	 * Returns the values of the sample defined by the coefficients at all the points of the plan.
+	 * \param coefficients The coefficients of the sample
+	 */
+	VectorType Evaluate(const VectorType& coefficients) const;
+
+	/**
+	 * Same as Evaluate, but the values are written to the given buffer. No memory is allocated.
+	 * \param coefficients The coefficients of the sample
+	 * \param values Output parameter. A buffer with space for (at least) GetNumberOfPoints() * Representer::GetDimensions() values.
+	 */
+	void EvaluateInto(const VectorType& coefficients, ScalarType* values) const;
+
+	/**
+	 * Returns the jacobian of the model with respect to the coefficients, evaluated at all the points of the plan.
+	 * The rows i * Representer::GetDimensions() to (i+1) * Representer::GetDimensions() - 1 correspond to the
+	 * jacobian returned by StatisticalModel::GetJacobian for the i-th point.
+	 * As the model is linear, this is just the part of the PCA basis that belongs to the points.
+	 */
+	const MatrixType& GetJacobian() const { return m_basis; }
+
+	/**
+	 * Returns the mean of the model, evaluated at all the points of the plan
+	 */
+	const VectorType& GetMean() const { return m_mean; }
+
+	/**
+	 * Returns the covariance matrix of the model restricted to the points of the plan, i.e. the rows and columns
+	 * of StatisticalModel::GetCovarianceMatrix that belong to the points.
+	 */
+	MatrixType GetCovariance() const;
+
+	/**
+	 * Returns the coefficients of the latent variables, given the values at the points of the plan.
+	 * The result is the same as StatisticalModel::ComputeCoefficientsForPointIDValues, but the system matrix
+	 * is not rebuilt and refactorized for each call.
+	 *
+	 * \param values The values at the points in their vectorial representation (ordered as the values returned by Evaluate)
+	 */
+	VectorType ComputeCoefficientsForValues(const VectorType& values) const;
+
+
+private:
+
+	EvaluationPlan(const StatisticalModelType* model, const PointIdListType& pointIds, double pointValueNoiseVariance);
+
+	// to prevent use
+	EvaluationPlan(const EvaluationPlan& orig);
+	EvaluationPlan& operator=(const EvaluationPlan& rhs);
+
+	PointIdListType m_pointIds;
+	VectorType m_mean;
+	MatrixType m_basis;
+	float m_noiseVariance;
+
+	// cholesky factorization of the matrix B^T B + sigma^2 I, where B is the packed basis
+	Eigen::LLT<MatrixTypeDoublePrecision> m_MCholesky;
+};
+
+
+} // namespace statismo
+
+#include "EvaluationPlan.txx"
+
+#endif /* __EVALUATIONPLAN_H_ */
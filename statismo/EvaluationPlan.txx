@@ -0,0 +1,133 @@
+/*
+ * This file is part of the statismo library.
+ *
+ * Author: Marcel Luethi (marcel.luethi@unibas.ch)
+ *
+ * Copyright (c) 2011 University of Basel
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ *
+ * Neither the name of the project's author nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+ * TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS addINTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#include "EvaluationPlan.h"
+#include "Exceptions.h"
+#include "MixedPrecision.h"
+
+namespace statismo {
+
+
+template <typename Representer>
+EvaluationPlan<Representer>::EvaluationPlan(const StatisticalModelType* model, const PointIdListType& pointIds, double pointValueNoiseVariance)
+: m_pointIds(pointIds),
+  m_noiseVariance(model->GetNoiseVariance())
+{
+	// resolve the point ids once and gather the corresponding rows into a contiguous submodel
+	std::vector<unsigned> indices = model->MapPointIdsToInternalIndices(pointIds);
+
+	const VectorType& mean = model->GetMeanVector();
+	ConstMatrixViewType basis = model->GetPCABasisMatrixView();
+
+	m_mean.resize(indices.size());
+	m_basis.resize(indices.size(), basis.cols());
+	for (unsigned i = 0; i < indices.size(); i++) {
+		m_mean[i] = mean[indices[i]];
+		m_basis.row(i) = basis.row(indices[i]);
+	}
+
+	// the system for the coefficients is accumulated and factorized in double precision, as it
+	// is often badly conditioned when only a few points are given
+	double noiseVariance = std::max(pointValueNoiseVariance, (double) m_noiseVariance);
+	MatrixTypeDoublePrecision M = MixedPrecision::TransposeTimesSelf(m_basis);
+	M.diagonal().array() += noiseVariance;
+	m_MCholesky.compute(M);
+	if (m_MCholesky.info() != Eigen::Success) {
+		throw StatisticalModelException("The system for the coefficients of the evaluation plan is singular. Use more points or a positive pointValueNoiseVariance.");
+	}
+}
+
+
+template <typename Representer>
+EvaluationPlan<Representer>*
+EvaluationPlan<Representer>::CreateFromPoints(const StatisticalModelType* model, const PointListType& points, double pointValueNoiseVariance) {
+
+	PointIdListType pointIds(points.size());
+	for (unsigned i = 0; i < points.size(); i++) {
+		pointIds[i] = model->GetRepresenter()->GetPointIdForPoint(points[i]);
+	}
+	return new EvaluationPlan(model, pointIds, pointValueNoiseVariance);
+}
+
+
+template <typename Representer>
+VectorType
+EvaluationPlan<Representer>::Evaluate(const VectorType& coefficients) const {
+	VectorType values(m_mean.rows());
+	EvaluateInto(coefficients, values.data());
+	return values;
+}
+
+
+template <typename Representer>
+void
+EvaluationPlan<Representer>::EvaluateInto(const VectorType& coefficients, ScalarType* values) const {
+
+	if (coefficients.size() != m_basis.cols()) {
+		throw StatisticalModelException("Incorrect number of coefficients provided !");
+	}
+
+	Eigen::Map<VectorType> v(values, m_mean.rows());
+	v.noalias() = m_basis * coefficients;
+	v += m_mean;
+}
+
+
+template <typename Representer>
+MatrixType
+EvaluationPlan<Representer>::GetCovariance() const {
+	MatrixType cov = m_basis * m_basis.transpose();
+	cov.diagonal().array() += m_noiseVariance;
+	return cov;
+}
+
+
+template <typename Representer>
+VectorType
+EvaluationPlan<Representer>::ComputeCoefficientsForValues(const VectorType& values) const {
+
+	if (values.rows() != m_mean.rows()) {
+		throw StatisticalModelException("The number of values does not match the number of points of the evaluation plan!");
+	}
+
+	VectorTypeDoublePrecision rhs = MixedPrecision::TransposeTimes(m_basis, values - m_mean);
+	return m_MCholesky.solve(rhs).cast<ScalarType>();
+}
+
+
+} // namespace statismo
@@ -122,6 +122,40 @@ void HDF5Utils::readMatrix(const H5::CommonFG& fg, const char* name, MatrixType&
 }
 
 
+inline
+void HDF5Utils::readMatrixDimensions(const H5::CommonFG& fg, const char* name, unsigned& nRows, unsigned& nCols) {
+	H5::DataSet ds = fg.openDataSet( name );
+	hsize_t dims[2];
+	ds.getSpace().getSimpleExtentDims(dims, NULL);
+	nRows = static_cast<unsigned>(dims[0]);
+	nCols = static_cast<unsigned>(dims[1]);
+}
+
+
+inline
+void HDF5Utils::readMatrixRows(const H5::CommonFG& fg, const char* name, unsigned firstRow, unsigned nRows, MatrixType& matrix) {
+	H5::DataSet ds = fg.openDataSet( name );
+	hsize_t dims[2];
+	ds.getSpace().getSimpleExtentDims(dims, NULL);
+
+	if (firstRow + nRows > dims[0]) {
+		throw StatisticalModelException("Invalid rows requested in readMatrixRows");
+	}
+
+	hsize_t offset[2] = {firstRow, 0};   // hyperslab offset in the file
+	hsize_t count[2] = {nRows, dims[1]};
+
+	H5::DataSpace dataspace = ds.getSpace();
+	dataspace.selectHyperslab( H5S_SELECT_SET, count, offset );
+
+	/* Define the memory dataspace. */
+	H5::DataSpace memspace( 2, count );
+
+	matrix.resize(nRows, dims[1]);
+	ds.read(matrix.data(), H5::PredType::NATIVE_FLOAT, memspace, dataspace);
+}
+
+
 inline
 void HDF5Utils::readMatrix(const H5::CommonFG& fg, const char* name, unsigned maxNumColumns, MatrixType& matrix) {
 	H5::DataSet ds = fg.openDataSet( name );
@@ -168,6 +202,37 @@ void HDF5Utils::writeMatrix(const H5::CommonFG& fg, const char* name, const Matr
 	ds.write( matrix.data(), H5::PredType::NATIVE_FLOAT );
 }
 
+inline
+void HDF5Utils::createMatrix(const H5::CommonFG& fg, const char* name, unsigned nRows, unsigned nCols) {
+	if (nRows == 0 || nCols == 0) {
+		throw StatisticalModelException("Empty matrix provided to createMatrix");
+	}
+
+	hsize_t dims[2] = {nRows, nCols};
+	fg.createDataSet( name, H5::PredType::NATIVE_FLOAT, H5::DataSpace(2, dims));
+}
+
+inline
+void HDF5Utils::writeMatrixRows(const H5::CommonFG& fg, const char* name, unsigned firstRow, const MatrixType& rows) {
+	H5::DataSet ds = fg.openDataSet( name );
+	hsize_t dims[2];
+	ds.getSpace().getSimpleExtentDims(dims, NULL);
+
+	hsize_t nRows = static_cast<hsize_t>(rows.rows());
+	if (firstRow + nRows > dims[0] || static_cast<hsize_t>(rows.cols()) != dims[1]) {
+		throw StatisticalModelException("Invalid rows provided to writeMatrixRows");
+	}
+
+	hsize_t offset[2] = {firstRow, 0};   // hyperslab offset in the file
+	hsize_t count[2] = {nRows, dims[1]};
+
+	H5::DataSpace dataspace = ds.getSpace();
+	dataspace.selectHyperslab( H5S_SELECT_SET, count, offset );
+
+	H5::DataSpace memspace( 2, count );
+	ds.write(rows.data(), H5::PredType::NATIVE_FLOAT, memspace, dataspace);
+}
+
 inline
 void HDF5Utils::readVector(const H5::CommonFG& fg, const char* name, VectorType& vector) {
 	H5::DataSet ds = fg.openDataSet( name );
@@ -218,6 +283,55 @@ void HDF5Utils::writeVector(const H5::CommonFG& fg, const char* name, const Vect
 
 }
 
+inline
+void HDF5Utils::readVectorElements(const H5::CommonFG& fg, const char* name, unsigned firstElement, unsigned nElements, VectorType& vector) {
+	H5::DataSet ds = fg.openDataSet( name );
+	hsize_t dims[1];
+	ds.getSpace().getSimpleExtentDims(dims, NULL);
+
+	if (firstElement + nElements > dims[0]) {
+		throw StatisticalModelException("Invalid elements requested in readVectorElements");
+	}
+
+	hsize_t offset[1] = {firstElement};   // hyperslab offset in the file
+	hsize_t count[1] = {nElements};
+
+	H5::DataSpace dataspace = ds.getSpace();
+	dataspace.selectHyperslab( H5S_SELECT_SET, count, offset );
+
+	H5::DataSpace memspace( 1, count );
+
+	vector.resize(nElements);
+	ds.read(vector.data(), H5::PredType::NATIVE_FLOAT, memspace, dataspace);
+}
+
+inline
+void HDF5Utils::createVector(const H5::CommonFG& fg, const char* name, unsigned nElements) {
+	hsize_t dims[1] = {nElements};
+	fg.createDataSet( name, H5::PredType::NATIVE_FLOAT, H5::DataSpace(1, dims));
+}
+
+inline
+void HDF5Utils::writeVectorElements(const H5::CommonFG& fg, const char* name, unsigned firstElement, const VectorType& elements) {
+	H5::DataSet ds = fg.openDataSet( name );
+	hsize_t dims[1];
+	ds.getSpace().getSimpleExtentDims(dims, NULL);
+
+	hsize_t nElements = static_cast<hsize_t>(elements.rows());
+	if (firstElement + nElements > dims[0]) {
+		throw StatisticalModelException("Invalid elements provided to writeVectorElements");
+	}
+
+	hsize_t offset[1] = {firstElement};   // hyperslab offset in the file
+	hsize_t count[1] = {nElements};
+
+	H5::DataSpace dataspace = ds.getSpace();
+	dataspace.selectHyperslab( H5S_SELECT_SET, count, offset );
+
+	H5::DataSpace memspace( 1, count );
+	ds.write(elements.data(), H5::PredType::NATIVE_FLOAT, memspace, dataspace);
+}
+
 inline
 void HDF5Utils::writeString(const H5::CommonFG& fg, const char* name, const std::string& s) {
 	H5::StrType fls_type(H5::PredType::C_S1, s.length() + 1); // + 1 for trailing zero
@@ -100,6 +100,45 @@ public:
 	 */
 	static void writeMatrix(const H5::CommonFG& fg, const char* name, const MatrixType& matrix);
 
+	/**
+	 * Create a Matrix with the given dimensions in the HDF5 File, whose rows are then written with writeMatrixRows.
+	 * This allows for writing large matrices block by block, without holding them completely in memory.
+	 * @param fg The group
+	 * @param name the name of the entry
+	 * @param nRows The number of rows
+	 * @param nCols The number of columns
+	 */
+	static void createMatrix(const H5::CommonFG& fg, const char* name, unsigned nRows, unsigned nCols);
+
+	/**
+	 * Write the rows firstRow, ..., firstRow + rows.rows() - 1 of a Matrix that was created with createMatrix
+	 * @param fg The group
+	 * @param name the name of the entry
+	 * @param firstRow The first row to be written
+	 * @param rows The rows to be written
+	 */
+	static void writeMatrixRows(const H5::CommonFG& fg, const char* name, unsigned firstRow, const MatrixType& rows);
+
+	/**
+	 * Read the number of rows and columns of a matrix in the HDF5 File
+	 * @param fg The group
+	 * @param name the name of the entry
+	 * @param nRows Output parameter, the number of rows
+	 * @param nCols Output parameter, the number of columns
+	 */
+	static void readMatrixDimensions(const H5::CommonFG& fg, const char* name, unsigned& nRows, unsigned& nCols);
+
+	/**
+	 * Read the rows firstRow, ..., firstRow + nRows - 1 of a Matrix from a HDF5 File.
+	 * This allows for processing large matrices block by block, without reading them completely into memory.
+	 * @param fg The group
+	 * @param name the name of the entry
+	 * @param firstRow The first row to be read
+	 * @param nRows The number of rows to be read
+	 * @param the output matrix
+	 */
+	static void readMatrixRows(const H5::CommonFG& fg, const char* name, unsigned firstRow, unsigned nRows, MatrixType& matrix);
+
 	/**
 	 * Read a Vector from a HDF5 File with the given number of elements
 	 * @param fg The group
@@ -127,6 +166,33 @@ public:
 	 */
 	static void writeVector(const H5::CommonFG& fg, const char* name, const VectorType& vector);
 
+	/**
+	 * Read the elements firstElement, ..., firstElement + nElements - 1 of a Vector from a HDF5 File
+	 * @param fg The group
+	 * @param name the name of the entry
+	 * @param firstElement The first element to be read
+	 * @param nElements The number of elements to be read
+	 * @param the output vector
+	 */
+	static void readVectorElements(const H5::CommonFG& fg, const char* name, unsigned firstElement, unsigned nElements, VectorType& vector);
+
+	/**
+	 * Create a Vector with the given number of elements in the HDF5 File, whose elements are then written with writeVectorElements
+	 * @param fg The group
+	 * @param name the name of the entry
+	 * @param nElements The number of elements
+	 */
+	static void createVector(const H5::CommonFG& fg, const char* name, unsigned nElements);
+
+	/**
+	 * Write the elements firstElement, ..., firstElement + elements.rows() - 1 of a Vector that was created with createVector
+	 * @param fg The group
+	 * @param name the name of the entry
+	 * @param firstElement The first element to be written
+	 * @param elements The elements to be written
+	 */
+	static void writeVectorElements(const H5::CommonFG& fg, const char* name, unsigned firstElement, const VectorType& elements);
+
 	/**
 	 * Reads a file (in binary mode) and saves it as a byte array in the hdf5 file.
 	 * @param filename The filename of the file to be stored
@@ -0,0 +1,120 @@
+/*
+ * This file is part of the statismo library.
+ *
+ * Author: Marcel Luethi (marcel.luethi@unibas.ch)
+ *
+ * Copyright (c) 2011 University of Basel
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ *
+ * Neither the name of the project's author nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+ * TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS addINTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#ifndef __MarginalModelBuilder_H_
+#define __MarginalModelBuilder_H_
+
+#include "Config.h"
+#include "ModelInfo.h"
+#include "ModelBuilder.h"
+#include "StatisticalModel.h"
+#include "SubsetRepresenter.h"
+#include "CommonTypes.h"
+#include <vector>
+
+namespace statismo {
+
+
+/**
+ * \brief Builds the marginal model of a given model on a subset of its points.
+ *
+ * The marginal distribution of a PPCA model on a subset of its points is again a PPCA model, whose mean and PCA basis
+ * consist of the rows of the original mean and basis that belong to the points of the subset. As the restricted
+ * basis is no longer orthogonal, it is re-orthonormalized, which yields the variances of the new model.
+ * The new model uses a SubsetRepresenter, and hence all its operations only scale with the size of the subset.
+ * This is useful for fitting on a region of interest, or for coarse to fine fitting strategies.
+ */
+template <typename Representer>
+class MarginalModelBuilder : public ModelBuilder<SubsetRepresenter<Representer> > {
+
+
+public:
+
+	typedef ModelBuilder<SubsetRepresenter<Representer> > Superclass;
+	typedef SubsetRepresenter<Representer> SubsetRepresenterType;
+	typedef typename Superclass::StatisticalModelType StatisticalModelType;
+	typedef StatisticalModel<Representer> InputModelType;
+	typedef std::vector<unsigned> PointIdListType;
+
+	/**
+	 * Factory method to create a new MarginalModelBuilder
+	 */
+	static MarginalModelBuilder* Create() { return new MarginalModelBuilder(); }
+
+	/**
+	 * Destroy the object.
+	 * The same effect can be achieved by deleting the object in the usual
+	 * way using the c++ delete keyword.
+	 */
+	void Delete() { delete this; }
+
+
+	/**
+	 * The desctructor
+	 */
+	virtual ~MarginalModelBuilder() {}
+
+	/**
+	 * Build the marginal model of the given model on the given points
+	 *
+	 * \param model A statistical model.
+	 * \param pointIds The ids of the points of the subset. The i-th point of the new model corresponds to the point pointIds[i] of the given model.
+	 * \param computeScores Determines whether the scores are computed and stored in the model.
+	 * \return a new statistical model
+	 *
+	 * \warning The returned model needs to be explicitly deleted by the user of this method.
+	 */
+	StatisticalModelType* BuildNewModelFromModel(const InputModelType* model, const PointIdListType& pointIds, bool computeScores=true) const;
+
+
+private:
+	// to prevent use
+	MarginalModelBuilder();
+	MarginalModelBuilder(const MarginalModelBuilder& orig);
+	MarginalModelBuilder& operator=(const MarginalModelBuilder& rhs);
+
+
+};
+
+
+
+} // namespace statismo
+
+#include "MarginalModelBuilder.txx"
+
+#endif /* __MarginalModelBuilder_H_ */
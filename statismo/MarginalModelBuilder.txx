@@ -0,0 +1,130 @@
+/*
+ * This file is part of the statismo library.
+ *
+ * Author: Marcel Luethi (marcel.luethi@unibas.ch)
+ *
+ * Copyright (c) 2011 University of Basel
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ *
+ * Neither the name of the project's author nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+ * TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS addINTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include <Eigen/Eigenvalues>
+#include "CommonTypes.h"
+#include "Exceptions.h"
+#include <memory>
+
+
+namespace statismo {
+
+
+template <typename Representer>
+MarginalModelBuilder<Representer>::MarginalModelBuilder()
+: Superclass()
+  {}
+
+
+template <typename Representer>
+typename MarginalModelBuilder<Representer>::StatisticalModelType*
+MarginalModelBuilder<Representer>::BuildNewModelFromModel(
+		const InputModelType* inputModel,
+		const PointIdListType& pointIds,
+		bool computeScores) const
+{
+	// gather the rows of the mean and the basis that belong to the points (this also checks the point ids)
+	std::vector<unsigned> indices = inputModel->MapPointIdsToInternalIndices(pointIds);
+
+	const VectorType& mean = inputModel->GetMeanVector();
+	ConstMatrixViewType W = inputModel->GetPCABasisMatrixView();
+
+	VectorType subsetMean(indices.size());
+	MatrixTypeDoublePrecision subsetW(indices.size(), W.cols());
+	for (unsigned i = 0; i < indices.size(); i++) {
+		subsetMean[i] = mean[indices[i]];
+		subsetW.row(i) = W.row(indices[i]).cast<double>();
+	}
+
+	// The covariance of the marginal model is W_s W_s^T + sigma^2 I. We obtain its principal components from the
+	// eigendecomposition W_s^T W_s = V L V^T of the small k x k matrix: the orthonormal basis is W_s V L^{-1/2} and the variances are L.
+	Eigen::SelfAdjointEigenSolver<MatrixTypeDoublePrecision> es(subsetW.transpose() * subsetW);
+	const VectorTypeDoublePrecision& eigenvalues = es.eigenvalues();
+
+	// the eigenvalues are sorted in increasing order. We keep those that are non-zero, in decreasing order
+	unsigned numComponents = 0;
+	for (unsigned i = 0; i < eigenvalues.rows(); i++) {
+		if (eigenvalues(i) > Superclass::TOLERANCE) {
+			numComponents++;
+		}
+	}
+
+	MatrixTypeDoublePrecision V(W.cols(), numComponents);
+	VectorType pcaVariance(numComponents);
+	for (unsigned j = 0; j < numComponents; j++) {
+		unsigned i = eigenvalues.rows() - 1 - j;
+		V.col(j) = es.eigenvectors().col(i);
+		pcaVariance(j) = eigenvalues(i);
+	}
+	VectorTypeDoublePrecision invSqrtVariance = pcaVariance.cast<double>().array().sqrt().inverse();
+	MatrixType orthonormalBasis = (subsetW * V * invSqrtVariance.asDiagonal()).cast<ScalarType>();
+
+	std::auto_ptr<SubsetRepresenterType> representer(SubsetRepresenterType::Create(inputModel->GetRepresenter(), pointIds, mean));
+
+	StatisticalModelType* marginalModel = StatisticalModelType::Create(
+			representer.get(),
+			subsetMean,
+			orthonormalBasis,
+			pcaVariance,
+			inputModel->GetNoiseVariance());
+
+	// Write the parameters used to build the models into the builderInfo
+	typename ModelInfo::BuilderInfoList builderInfoList = inputModel->GetModelInfo().GetBuilderInfoList();
+
+	BuilderInfo::ParameterInfoList bi;
+	bi.push_back(BuilderInfo::KeyValuePair("numberOfPoints ", Utils::toString(pointIds.size())));
+
+	BuilderInfo::DataInfoList di;
+
+	BuilderInfo builderInfo("MarginalModelBuilder", di, bi);
+	builderInfoList.push_back(builderInfo);
+
+	// the sample W alpha of the input model is W_s V L^{1/2} (V^T alpha) on the subset. Hence, the scores of the marginal model are V^T alpha
+	MatrixType scores(0, 0);
+	const MatrixType& inputScores = inputModel->GetModelInfo().GetScoresMatrix();
+	if (computeScores && inputScores.rows() == W.cols()) {
+		scores = (V.transpose() * inputScores.cast<double>()).cast<ScalarType>();
+	}
+
+	ModelInfo info(scores, builderInfoList);
+	marginalModel->SetModelInfo(info);
+
+	return marginalModel;
+}
+
+
+} // namespace statismo
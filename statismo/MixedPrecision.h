@@ -0,0 +1,175 @@
+/*
+ * This file is part of the statismo library.
+ *
+ * Author: Marcel Luethi (marcel.luethi@unibas.ch)
+ *
+ * Copyright (c) 2011 University of Basel
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ *
+ * Neither the name of the project's author nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+ * TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS addINTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#ifndef __MIXEDPRECISION_H_
+#define __MIXEDPRECISION_H_
+
+#include "CommonTypes.h"
+#include <algorithm>
+
+namespace statismo {
+
+/**
+ * \brief Matrix products that read single precision matrices, but accumulate the result in double precision.
+ *
+ * The model data (mean and basis) is stored in single precision (see ScalarType). The products computed here are
+ * sums over all the p rows of the basis, and accumulating them in single precision loses several digits for large p.
+ * The kernels therefore convert a block of BLOCK_SIZE rows (or columns) at a time to double precision and
+ * accumulate the product of the block into a double precision result. The additional memory is bounded by the size of
+ * a block, and the single precision data is read only once.
+ *
+ * The kernels accept any matrix expression, in particular the views returned by StatisticalModel::GetPCABasisMatrixView.
+ *
+ * This class is used internally by statismo and is not part of the public interface.
+ */
+class MixedPrecision {
+public:
+
+	/// number of rows that are converted to double precision at once. An enum, such that it is never ODR-used (e.g. by std::min)
+	enum { BLOCK_SIZE = 256 };
+
+	/** Returns A^T A (the Gram matrix of the columns of A) */
+	template <typename Derived>
+	static MatrixTypeDoublePrecision TransposeTimesSelf(const Eigen::MatrixBase<Derived>& A) {
+		MatrixTypeDoublePrecision result = MatrixTypeDoublePrecision::Zero(A.cols(), A.cols());
+		MatrixTypeDoublePrecision block;
+		for (unsigned i = 0; i < A.rows(); i += BLOCK_SIZE) {
+			unsigned n = std::min<unsigned>(BLOCK_SIZE, A.rows() - i);
+			block = A.middleRows(i, n).template cast<double>();
+			result.noalias() += block.transpose() * block;
+		}
+		return result;
+	}
+
+	/** Returns A^T diag(w) A */
+	template <typename Derived>
+	static MatrixTypeDoublePrecision TransposeTimesSelf(const Eigen::MatrixBase<Derived>& A, const VectorType& w) {
+		assert(w.rows() == A.rows());
+		MatrixTypeDoublePrecision result = MatrixTypeDoublePrecision::Zero(A.cols(), A.cols());
+		MatrixTypeDoublePrecision block;
+		MatrixTypeDoublePrecision weightedBlock;
+		for (unsigned i = 0; i < A.rows(); i += BLOCK_SIZE) {
+			unsigned n = std::min<unsigned>(BLOCK_SIZE, A.rows() - i);
+			block = A.middleRows(i, n).template cast<double>();
+			VectorTypeDoublePrecision blockWeights = w.segment(i, n).cast<double>();
+			weightedBlock.noalias() = blockWeights.asDiagonal() * block;
+			result.noalias() += block.transpose() * weightedBlock;
+		}
+		return result;
+	}
+
+	/** Returns A A^T (the Gram matrix of the rows of A). The blocks are taken over the columns of A. */
+	template <typename Derived>
+	static MatrixTypeDoublePrecision TimesTransposeSelf(const Eigen::MatrixBase<Derived>& A) {
+		MatrixTypeDoublePrecision result = MatrixTypeDoublePrecision::Zero(A.rows(), A.rows());
+		MatrixTypeDoublePrecision block;
+		for (unsigned j = 0; j < A.cols(); j += BLOCK_SIZE) {
+			unsigned n = std::min<unsigned>(BLOCK_SIZE, A.cols() - j);
+			block = A.middleCols(j, n).template cast<double>();
+			result.noalias() += block * block.transpose();
+		}
+		return result;
+	}
+
+	/** Returns A^T v */
+	template <typename Derived>
+	static VectorTypeDoublePrecision TransposeTimes(const Eigen::MatrixBase<Derived>& A, const VectorType& v) {
+		assert(v.rows() == A.rows());
+		VectorTypeDoublePrecision result = VectorTypeDoublePrecision::Zero(A.cols());
+		MatrixTypeDoublePrecision block;
+		for (unsigned i = 0; i < A.rows(); i += BLOCK_SIZE) {
+			unsigned n = std::min<unsigned>(BLOCK_SIZE, A.rows() - i);
+			block = A.middleRows(i, n).template cast<double>();
+			VectorTypeDoublePrecision blockVector = v.segment(i, n).cast<double>();
+			result.noalias() += block.transpose() * blockVector;
+		}
+		return result;
+	}
+
+	/** Returns A^T B^T, where B has as many columns as A has rows (e.g. a matrix with one sample per row) */
+	template <typename Derived>
+	static MatrixTypeDoublePrecision TransposeTimesTransposed(const Eigen::MatrixBase<Derived>& A, const MatrixType& B) {
+		assert(B.cols() == A.rows());
+		MatrixTypeDoublePrecision result = MatrixTypeDoublePrecision::Zero(A.cols(), B.rows());
+		MatrixTypeDoublePrecision blockA;
+		MatrixTypeDoublePrecision blockB;
+		for (unsigned i = 0; i < A.rows(); i += BLOCK_SIZE) {
+			unsigned n = std::min<unsigned>(BLOCK_SIZE, A.rows() - i);
+			blockA = A.middleRows(i, n).template cast<double>();
+			blockB = B.middleCols(i, n).cast<double>();
+			result.noalias() += blockA.transpose() * blockB.transpose();
+		}
+		return result;
+	}
+
+	/** Returns A B, where A is a single precision and B a double precision matrix. The blocks are taken over the columns of A. */
+	template <typename Derived>
+	static MatrixTypeDoublePrecision TimesDoublePrecision(const Eigen::MatrixBase<Derived>& A, const MatrixTypeDoublePrecision& B) {
+		assert(B.rows() == A.cols());
+		MatrixTypeDoublePrecision result = MatrixTypeDoublePrecision::Zero(A.rows(), B.cols());
+		MatrixTypeDoublePrecision block;
+		for (unsigned j = 0; j < A.cols(); j += BLOCK_SIZE) {
+			unsigned n = std::min<unsigned>(BLOCK_SIZE, A.cols() - j);
+			block = A.middleCols(j, n).template cast<double>();
+			result.noalias() += block * B.middleRows(j, n);
+		}
+		return result;
+	}
+
+	/** Returns A^T B, where A is a single precision and B a double precision matrix */
+	template <typename Derived>
+	static MatrixTypeDoublePrecision TransposeTimesDoublePrecision(const Eigen::MatrixBase<Derived>& A, const MatrixTypeDoublePrecision& B) {
+		assert(B.rows() == A.rows());
+		MatrixTypeDoublePrecision result = MatrixTypeDoublePrecision::Zero(A.cols(), B.cols());
+		MatrixTypeDoublePrecision block;
+		for (unsigned i = 0; i < A.rows(); i += BLOCK_SIZE) {
+			unsigned n = std::min<unsigned>(BLOCK_SIZE, A.rows() - i);
+			block = A.middleRows(i, n).template cast<double>();
+			result.noalias() += block.transpose() * B.middleRows(i, n);
+		}
+		return result;
+	}
+
+private:
+	// to prevent use
+	MixedPrecision();
+};
+
+} // namespace statismo
+
+#endif /* __MIXEDPRECISION_H_ */
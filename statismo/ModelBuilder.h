@@ -68,11 +68,7 @@ protected:
 
 	MatrixType ComputeScores(const MatrixType& X, const StatisticalModelType* model) const {
 
-		MatrixType scores(model->GetNumberOfPrincipalComponents(), X.rows());
-		for (unsigned i = 0; i < scores.cols(); i++) {
-			scores.col(i) = model->ComputeCoefficientsForSampleVector(X.row(i));
-		}
-		return scores;
+		return model->ComputeCoefficientsForSampleMatrix(X);
 	}
 
 
@@ -0,0 +1,160 @@
+/*
+ * This file is part of the statismo library.
+ *
+ * Author: Marcel Luethi (marcel.luethi@unibas.ch)
+ *
+ * Copyright (c) 2011 University of Basel
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ *
+ * Neither the name of the project's author nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+ * TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS addINTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#ifndef __MODELINSTANCE_H_
+#define __MODELINSTANCE_H_
+
+#include "Config.h"
+#include "StatisticalModel.h"
+#include "CommonTypes.h"
+#include <vector>
+
+namespace statismo {
+
+
+/**
+ * \brief A sample of a StatisticalModel, that is updated incrementally when its coefficients change.
+ *
+ * Optimizers often change only one or a few coefficients at a time (e.g. for finite differences or coordinate descent).
+ * Drawing a new sample for each change costs \f$O(pk)\f$. A ModelInstance holds the current coefficients together with the
+ * sample vector \f$\mu + W \alpha\f$, and updates the sample by adding the scaled column of the PCA basis when a single coefficient
+ * changes. The cost per changed coefficient is thus only \f$O(p)\f$.
+ *
+ * To prevent the accumulation of rounding errors, the sample is recomputed from scratch after
+ * GetNumberOfPrincipalComponents() incremental updates. The amortized cost of an update remains \f$O(p)\f$.
+ *
+ * \warning The instance only references the model. The model must not be deleted as long as the instance is in use.
+ */
+template <typename Representer>
+class ModelInstance {
+public:
+
+	typedef StatisticalModel<Representer> StatisticalModelType;
+	typedef typename Representer::DatasetPointerType DatasetPointerType;
+	typedef typename Representer::ValueType ValueType;
+
+	/**
+	 * Factory method that creates a new instance, which represents the mean of the model
+	 * \param model The statistical model
+	 */
+	static ModelInstance* Create(const StatisticalModelType* model) {
+		return new ModelInstance(model, VectorType::Zero(model->GetNumberOfPrincipalComponents()));
+	}
+
+	/**
+	 * Factory method that creates a new instance with the given coefficients
+	 * \param model The statistical model
+	 * \param coefficients The coefficients of the instance
+	 */
+	static ModelInstance* Create(const StatisticalModelType* model, const VectorType& coefficients) {
+		return new ModelInstance(model, coefficients);
+	}
+
+	/**
+	 * Destroy the object.
+	 * The same effect can be achieved by deleting the object in the usual
+	 * way using the c++ delete keyword.
+	 */
+	void Delete() const { delete this; }
+
+	/**
+	 * Destructor
+	 */
+	virtual ~ModelInstance() {}
+
+	/**
+	 * Sets all the coefficients. The sample is recomputed from scratch (\f$O(pk)\f$).
+	 */
+	void SetCoefficients(const VectorType& coefficients);
+
+	/**
+	 * Sets the i-th coefficient to the given value. The sample is updated in \f$O(p)\f$.
+	 */
+	void SetCoefficient(unsigned i, ScalarType value);
+
+	/**
+	 * Sets the coefficients with the given indices to the given values. The sample is updated in
+	 * \f$O(pn)\f$, where n is the number of changed coefficients.
+	 */
+	void SetCoefficients(const std::vector<unsigned>& indices, const VectorType& values);
+
+	/**
+	 * \return The current coefficients
+	 */
+	const VectorType& GetCoefficients() const { return m_coefficients; }
+
+	/**
+	 * \return The sample vector that corresponds to the current coefficients
+	 */
+	const VectorType& GetSampleVector() const { return m_sample; }
+
+	/**
+	 * \return The value of the current sample at the point with the given id
+	 */
+	ValueType GetValueAtPoint(unsigned ptId) const;
+
+	/**
+	 * \return A new dataset, that represents the current sample
+	 */
+	DatasetPointerType GetSample() const;
+
+private:
+
+	ModelInstance(const StatisticalModelType* model, const VectorType& coefficients);
+
+	// to prevent use
+	ModelInstance(const ModelInstance& orig);
+	ModelInstance& operator=(const ModelInstance& rhs);
+
+	// adds the contribution of the change of the i-th coefficient to the sample
+	void UpdateCoefficient(unsigned i, ScalarType value);
+
+	const StatisticalModelType* m_model;
+	VectorType m_coefficients;
+	VectorType m_sample;
+
+	// the number of incremental updates since the sample has been computed from scratch
+	unsigned m_numberOfUpdates;
+};
+
+
+} // namespace statismo
+
+#include "ModelInstance.txx"
+
+#endif /* __MODELINSTANCE_H_ */
@@ -0,0 +1,136 @@
+/*
+ * This file is part of the statismo library.
+ *
+ * Author: Marcel Luethi (marcel.luethi@unibas.ch)
+ *
+ * Copyright (c) 2011 University of Basel
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ *
+ * Neither the name of the project's author nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+ * TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS addINTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#include "ModelInstance.h"
+#include "Exceptions.h"
+
+namespace statismo {
+
+
+template <typename Representer>
+ModelInstance<Representer>::ModelInstance(const StatisticalModelType* model, const VectorType& coefficients)
+: m_model(model), m_sample(model->GetMeanVector().rows())
+{
+	SetCoefficients(coefficients);
+}
+
+
+template <typename Representer>
+void
+ModelInstance<Representer>::SetCoefficients(const VectorType& coefficients) {
+	m_model->DrawSampleVectorInto(coefficients, m_sample.data());
+	m_coefficients = coefficients;
+	m_numberOfUpdates = 0;
+}
+
+
+template <typename Representer>
+void
+ModelInstance<Representer>::SetCoefficient(unsigned i, ScalarType value) {
+
+	if (i >= m_coefficients.rows()) {
+		throw StatisticalModelException("Invalid coefficient index provided to ModelInstance::SetCoefficient");
+	}
+	UpdateCoefficient(i, value);
+}
+
+
+template <typename Representer>
+void
+ModelInstance<Representer>::SetCoefficients(const std::vector<unsigned>& indices, const VectorType& values) {
+
+	if (indices.size() != static_cast<unsigned>(values.rows())) {
+		throw StatisticalModelException("The number of indices and values provided to ModelInstance::SetCoefficients do not match");
+	}
+	for (unsigned j = 0; j < indices.size(); j++) {
+		if (indices[j] >= m_coefficients.rows()) {
+			throw StatisticalModelException("Invalid coefficient index provided to ModelInstance::SetCoefficients");
+		}
+	}
+
+	for (unsigned j = 0; j < indices.size(); j++) {
+		UpdateCoefficient(indices[j], values[j]);
+	}
+}
+
+
+template <typename Representer>
+void
+ModelInstance<Representer>::UpdateCoefficient(unsigned i, ScalarType value) {
+
+	ScalarType delta = value - m_coefficients[i];
+	m_coefficients[i] = value;
+	if (delta == 0) {
+		return;
+	}
+
+	m_numberOfUpdates++;
+	if (m_numberOfUpdates >= m_coefficients.rows()) {
+		// after k updates, we have spent as much as a full recomputation would cost. We recompute the sample to
+		// get rid of the accumulated rounding errors
+		SetCoefficients(m_coefficients);
+	}
+	else {
+		m_sample += m_model->GetPCABasisMatrixView().col(i) * delta;
+	}
+}
+
+
+template <typename Representer>
+typename ModelInstance<Representer>::ValueType
+ModelInstance<Representer>::GetValueAtPoint(unsigned ptId) const {
+
+	typename StatisticalModelType::PointIdListType pointIds(1, ptId);
+	std::vector<unsigned> indices = m_model->MapPointIdsToInternalIndices(pointIds);
+
+	VectorType v(indices.size());
+	for (unsigned d = 0; d < indices.size(); d++) {
+		v[d] = m_sample[indices[d]];
+	}
+	return m_model->GetRepresenter()->PointSampleVectorToPointSample(v);
+}
+
+
+template <typename Representer>
+typename ModelInstance<Representer>::DatasetPointerType
+ModelInstance<Representer>::GetSample() const {
+	return m_model->GetRepresenter()->SampleVectorToSample(m_sample);
+}
+
+
+} // namespace statismo
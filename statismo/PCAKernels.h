@@ -0,0 +1,224 @@
+/*
+ * This file is part of the statismo library.
+ *
+ * Author: Marcel Luethi (marcel.luethi@unibas.ch)
+ *
+ * Copyright (c) 2011 University of Basel
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ *
+ * Neither the name of the project's author nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+ * TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS addINTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef __PCAKERNELS_H_
+#define __PCAKERNELS_H_
+
+#include "CommonTypes.h"
+#include <Eigen/SVD>
+#include <Eigen/Eigenvalues>
+#include <algorithm>
+#include <cassert>
+#include <utility>
+#include <vector>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+namespace statismo {
+
+/**
+ * \brief The building blocks of the PCA, which are shared by the PCAModelBuilder and the StreamingPCAModelBuilder.
+ *
+ * The products with a block of the centered data matrix (in double precision) are split into tiles of
+ * TILE_SIZE x TILE_SIZE entries of the result. If statismo is compiled with OpenMP, the tiles are computed in parallel
+ * by the given number of threads (0 means as many threads as OpenMP provides).
+ *
+ * This class is used internally by statismo and is not part of the public interface.
+ */
+class PCAKernels {
+public:
+
+	/// the number of rows and columns of a tile of the result (an enum, such that std::min does not ODR-use it)
+	enum { TILE_SIZE = 64 };
+
+	/** Returns the number of threads that are used, if numberOfThreads are requested */
+	static unsigned GetNumberOfThreadsToUse(unsigned numberOfThreads) {
+#ifdef _OPENMP
+		return (numberOfThreads > 0) ? numberOfThreads : omp_get_max_threads();
+#else
+		return 1;
+#endif
+	}
+
+	/**
+	 * Eigen queries the cache sizes, from which it derives the blocking of the products, on first use and stores them
+	 * in function statics that are not initialized in a thread safe way. This is therefore done before the parallel regions.
+	 */
+	static void InitializeEigenCacheSizes() {
+		std::ptrdiff_t l1, l2;
+		Eigen::internal::manage_caching_sizes(Eigen::GetAction, &l1, &l2);
+	}
+
+	/** Adds the lower triangle of A A^T to the lower triangle of result */
+	static void AddLowerTriangleOfTimesTransposeSelf(const MatrixTypeDoublePrecision& A, MatrixTypeDoublePrecision& result, unsigned numberOfThreads) {
+		assert(result.rows() == A.rows() && result.cols() == A.rows());
+
+		// the tiles (I, J) with I >= J cover the lower triangle. They are disjoint, and can therefore be updated in parallel.
+		unsigned m = A.rows();
+		std::vector<std::pair<unsigned, unsigned> > tiles;
+		for (unsigned i = 0; i < m; i += TILE_SIZE) {
+			for (unsigned j = 0; j <= i; j += TILE_SIZE) {
+				tiles.push_back(std::make_pair(i, j));
+			}
+		}
+
+		int numberOfTiles = tiles.size();
+		InitializeEigenCacheSizes();
+#ifdef _OPENMP
+		#pragma omp parallel for schedule(dynamic) num_threads(GetNumberOfThreadsToUse(numberOfThreads))
+#endif
+		for (int t = 0; t < numberOfTiles; t++) {
+			unsigned i = tiles[t].first;
+			unsigned j = tiles[t].second;
+			unsigned nRows = std::min<unsigned>(TILE_SIZE, m - i);
+			unsigned nCols = std::min<unsigned>(TILE_SIZE, m - j);
+			result.block(i, j, nRows, nCols).noalias() += A.middleRows(i, nRows) * A.middleRows(j, nCols).transpose();
+		}
+	}
+
+	/** Copies the lower triangle of A to the upper triangle */
+	static void CopyLowerToUpperTriangle(MatrixTypeDoublePrecision& A) {
+		for (unsigned i = 0; i < A.rows(); i++) {
+			for (unsigned j = i + 1; j < A.cols(); j++) {
+				A(i, j) = A(j, i);
+			}
+		}
+	}
+
+	/** Adds block * A to result. The rows of the result are updated in parallel, one tile of rows per task */
+	template <typename Derived>
+	static void AddTimes(const MatrixTypeDoublePrecision& block, const Eigen::MatrixBase<Derived>& A, MatrixTypeDoublePrecision& result, unsigned numberOfThreads) {
+		assert(result.rows() == block.rows() && result.cols() == A.cols());
+
+		unsigned n = block.rows();
+		int numberOfTiles = (n + TILE_SIZE - 1) / TILE_SIZE;
+		InitializeEigenCacheSizes();
+#ifdef _OPENMP
+		#pragma omp parallel for num_threads(GetNumberOfThreadsToUse(numberOfThreads))
+#endif
+		for (int t = 0; t < numberOfTiles; t++) {
+			unsigned i = t * TILE_SIZE;
+			unsigned nRows = std::min<unsigned>(TILE_SIZE, n - i);
+			result.middleRows(i, nRows).noalias() += block.middleRows(i, nRows) * A;
+		}
+	}
+
+	/**
+	 * Writes block^T A to the rows firstRow, ..., firstRow + block.cols() - 1 of result. The result can be a single
+	 * precision matrix, such that no double precision copy of a large product is needed.
+	 */
+	template <typename ResultMatrixType>
+	static void TransposeTimesIntoRows(const MatrixTypeDoublePrecision& block, const MatrixTypeDoublePrecision& A, unsigned firstRow, ResultMatrixType& result, unsigned numberOfThreads) {
+		assert(A.rows() == block.rows() && result.cols() == A.cols() && firstRow + block.cols() <= result.rows());
+
+		// the tiles read rows of the (row major) transposed block, i.e. contiguous memory
+		MatrixTypeDoublePrecision blockTransposed = block.transpose();
+		unsigned m = block.cols();
+		unsigned k = A.cols();
+		int numberOfRowTiles = (m + TILE_SIZE - 1) / TILE_SIZE;
+		int numberOfColTiles = (k + TILE_SIZE - 1) / TILE_SIZE;
+		int numberOfTiles = numberOfRowTiles * numberOfColTiles;
+		InitializeEigenCacheSizes();
+#ifdef _OPENMP
+		#pragma omp parallel for num_threads(GetNumberOfThreadsToUse(numberOfThreads))
+#endif
+		for (int t = 0; t < numberOfTiles; t++) {
+			unsigned r = (t / numberOfColTiles) * TILE_SIZE;
+			unsigned c = (t % numberOfColTiles) * TILE_SIZE;
+			unsigned nRows = std::min<unsigned>(TILE_SIZE, m - r);
+			unsigned nCols = std::min<unsigned>(TILE_SIZE, k - c);
+			MatrixTypeDoublePrecision tile = blockTransposed.middleRows(r, nRows) * A.middleCols(c, nCols);
+			result.block(firstRow + r, c, nRows, nCols) = tile.template cast<typename ResultMatrixType::Scalar>();
+		}
+	}
+
+	/**
+	 * Computes the eigenvalues (in descending order) and the eigenvectors of a symmetric, positive semi-definite matrix,
+	 * using either the JacobiSVD or the SelfAdjointEigenSolver (which only reads the lower triangle).
+	 */
+	static void ComputeEigenDecomposition(const MatrixTypeDoublePrecision& A, bool useJacobiSVD, VectorTypeDoublePrecision& eigenvalues, MatrixTypeDoublePrecision& eigenvectors) {
+		if (useJacobiSVD) {
+			// for a symmetric, positive semi-definite matrix, the singular values and vectors are the eigenvalues and eigenvectors
+			Eigen::JacobiSVD<MatrixTypeDoublePrecision> SVD(A, Eigen::ComputeThinU);
+			eigenvalues = SVD.singularValues();
+			eigenvectors = SVD.matrixU();
+		}
+		else {
+			// the SelfAdjointEigenSolver returns the eigenvalues in ascending order. We reverse the order
+			Eigen::SelfAdjointEigenSolver<MatrixTypeDoublePrecision> eigenSolver(A);
+			unsigned m = A.rows();
+			eigenvalues.resize(m);
+			eigenvectors.resize(m, m);
+			for (unsigned i = 0; i < m; i++) {
+				eigenvalues(i) = eigenSolver.eigenvalues()(m - 1 - i);
+				eigenvectors.col(i) = eigenSolver.eigenvectors().col(m - 1 - i);
+			}
+		}
+	}
+
+	/**
+	 * Returns the number of components that are kept, given the variances in descending order and the total variance of the data.
+	 * Only components whose variance exceeds the noise variance (by more than the tolerance) are kept, and at most
+	 * min(maxNumberOfComponents, rank). If varianceRetained < 1, only as many components are kept as are needed to
+	 * explain this fraction of the total variance.
+	 */
+	static unsigned GetNumberOfComponentsToKeep(const VectorTypeDoublePrecision& variances, double totalVariance, unsigned rank, double noiseVariance,
+			unsigned maxNumberOfComponents, double varianceRetained, double tolerance) {
+		unsigned maxNumComponents = std::min(std::min(maxNumberOfComponents, rank), unsigned(variances.rows()));
+
+		unsigned numComponents = 0;
+		while (numComponents < maxNumComponents && variances(numComponents) - noiseVariance - tolerance > 0) {
+			numComponents++;
+		}
+
+		if (varianceRetained < 1) {
+			double cumulatedVariance = 0;
+			for (unsigned i = 0; i < numComponents; i++) {
+				cumulatedVariance += variances(i);
+				if (cumulatedVariance >= varianceRetained * totalVariance) {
+					return i + 1;
+				}
+			}
+		}
+		return numComponents;
+	}
+};
+
+} // namespace statismo
+
+#endif /* __PCAKERNELS_H_ */
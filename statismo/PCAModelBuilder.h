@@ -44,6 +44,8 @@
 #include "DataManager.h"
 #include "StatisticalModel.h"
 #include "CommonTypes.h"
+#include "DataMatrixSource.h"
+#include "PCAKernels.h"
 #include <vector>
 #include <memory>
 
@@ -54,6 +56,31 @@ namespace statismo {
  * \brief Creates StatisticalModel using Principal Component Analysis.
  *
  * This class implements the classical PCA based approach to Statistical Models.
+ *
+ * The principal components are computed with one of the following solvers:
+ * - JACOBI_SVD: A singular value decomposition of the n x n inner product matrix (if there are fewer samples n than variables p)
+ *   or of the p x p covariance matrix. This is the most accurate, but also the slowest method.
+ * - SELF_ADJOINT_EIGEN_SOLVER: An eigendecomposition of the same (symmetric, positive semi-definite) matrices, which is
+ *   considerably faster than the SVD.
+ * - RANDOMIZED_SVD: A randomized SVD of the centered data matrix, which only computes the leading principal components
+ *   (see SetMaxNumberOfComponents and SetVarianceRetained). No n x n or p x p matrix is formed. For details, see
+ *   Finding structure with randomness: Probabilistic algorithms for constructing approximate matrix decompositions,
+ *   N. Halko, P. Martinsson and J. Tropp, SIAM Review 53(2), 2011
+ * - AUTOMATIC: The method is chosen by a cost model, which estimates the number of operations and the memory that each method needs
+ *   for the given number of samples, variables and components. The cheapest method that does not exceed the memory limit
+ *   (see SetMemoryLimitInMB) is used. The randomized SVD is only considered if the number of components is limited
+ *   with SetMaxNumberOfComponents.
+ *
+ * For the eigendecompositions, the cost model also decides whether the inner product or the covariance matrix is decomposed.
+ * The chosen method is reported in the BuilderInfo of the model.
+ *
+ * The builder does not copy the samples into a data matrix. The centered data is read block by block from the sample
+ * vectors whenever it is needed, and the products with it are accumulated block by block. Apart from the samples
+ * themselves, only the decomposed matrix (or the n x l and p x l matrices of the randomized SVD) and the resulting
+ * basis are held in memory.
+ *
+ * If statismo is compiled with OpenMP (see STATISMO_USE_OPENMP), the products with the data (in particular the inner product
+ * or covariance matrix and the reconstruction of the basis) are computed in parallel (see SetNumberOfThreads).
  */
 template <typename Representer>
 class PCAModelBuilder : public ModelBuilder<Representer> {
@@ -66,10 +93,25 @@ public:
 	typedef typename Superclass::StatisticalModelType StatisticalModelType;
 	typedef typename DataManagerType::SampleDataStructureListType SampleDataStructureListType;
 
+	/// The method used to compute the principal components (see the class description)
+	enum SolverType {
+		JACOBI_SVD,
+		SELF_ADJOINT_EIGEN_SOLVER,
+		RANDOMIZED_SVD,
+		AUTOMATIC
+	};
+
+	/// The number of additional directions that are sampled by the randomized SVD
+	enum { RANDOMIZED_SVD_OVERSAMPLING = 10 };
+
+	/// The number of power iterations of the randomized SVD, which improve the accuracy when the spectrum decays slowly
+	enum { RANDOMIZED_SVD_POWER_ITERATIONS = 2 };
+
 	/**
 	 * Factory method to create a new PCAModelBuilder
+	 * \param solverType The method used to compute the principal components
 	 */
-	static PCAModelBuilder* Create() { return new PCAModelBuilder(); }
+	static PCAModelBuilder* Create(SolverType solverType = AUTOMATIC) { return new PCAModelBuilder(solverType); }
 
 	/**
 	 * Destroy the object.
@@ -97,15 +139,94 @@ public:
 	 */
 	StatisticalModelType* BuildNewModel(const SampleDataStructureListType& samples, double noiseVariance, bool computeScores = true) const;
 
+	/**
+	 * Limits the number of principal components of the models that are built. By default, all the components are kept.
+	 * The randomized SVD only computes the components that are kept.
+	 */
+	void SetMaxNumberOfComponents(unsigned maxNumberOfComponents) { m_maxNumberOfComponents = maxNumberOfComponents; }
+
+	/**
+	 * Keep only as many principal components as are needed to explain the given fraction of the total variance
+	 * of the data. The default value of 1 keeps all the components.
+	 * The randomized SVD computes more components until the fraction is reached.
+	 */
+	void SetVarianceRetained(double varianceRetained) { m_varianceRetained = varianceRetained; }
+
+	/**
+	 * Sets the memory (in megabytes) that the computation of the principal components may use in addition to the data.
+	 * The cost model does not choose methods that need more memory. If no method fits, the method with the smallest memory
+	 * requirements is used. The default value of 0 means that the memory is not limited.
+	 */
+	void SetMemoryLimitInMB(double memoryLimitInMB) { m_memoryLimitInMB = memoryLimitInMB; }
+
+	/**
+	 * Sets the number of threads that are used to compute the products with the data. The default value of 0 uses
+	 * as many threads as OpenMP provides. Without OpenMP, the products are always computed by a single thread.
+	 */
+	void SetNumberOfThreads(unsigned numberOfThreads) { m_numberOfThreads = numberOfThreads; }
+
 
 private:
 	// to prevent use
-	PCAModelBuilder();
+	PCAModelBuilder(SolverType solverType);
 	PCAModelBuilder(const PCAModelBuilder& orig);
 	PCAModelBuilder& operator=(const PCAModelBuilder& rhs);
 
-	StatisticalModelType* BuildNewModelInternal(const Representer* representer, const MatrixType& X, double noiseVariance) const;
+	// the matrix from which the principal components are computed
+	enum DecompositionType {
+		INNER_PRODUCT_MATRIX,
+		COVARIANCE_MATRIX,
+		DATA_MATRIX
+	};
+
+	StatisticalModelType* BuildNewModelInternal(const Representer* representer, const DataMatrixSource& X0, const VectorType& mean,
+			double noiseVariance, SolverType solverType, DecompositionType decompositionType) const;
+
+	// chooses the solver and the matrix that is decomposed for n samples with p variables, using the cost model.
+	void ChooseMethod(unsigned n, unsigned p, SolverType& solverType, DecompositionType& decompositionType) const;
+
+	// estimates the number of floating point operations and the memory (in bytes) that the given method needs
+	void EstimateCost(unsigned n, unsigned p, SolverType solverType, DecompositionType decompositionType, double& flops, double& memory) const;
+
+	// returns the name of the method, as it is reported in the BuilderInfo
+	static std::string GetMethodName(SolverType solverType, DecompositionType decompositionType);
+
+	// computes the leading numberOfComponents eigenvalues and eigenvectors of the covariance matrix of the centered data X0
+	// using the randomized SVD.
+	void ComputeRandomizedPCA(const DataMatrixSource& X0, unsigned numberOfComponents, VectorTypeDoublePrecision& eigenvalues, MatrixTypeDoublePrecision& eigenvectors) const;
+
+	// The following products with the centered data matrix X0 read X0 block by block (see MixedPrecision::BLOCK_SIZE)
+	// and accumulate the result in double precision. The blocks are read by a single thread (the source need not be
+	// thread safe). The product of each block is computed in parallel tiles (see PCAKernels).
+
+	// returns the squared Frobenius norm of X0
+	static double ComputeSquaredNorm(const DataMatrixSource& X0);
+
+	// returns X0 X0^T, accumulated over blocks of columns. Only the lower triangle is computed.
+	MatrixTypeDoublePrecision ComputeInnerProductMatrix(const DataMatrixSource& X0) const;
+
+	// returns X0^T X0, accumulated over blocks of rows. Only the lower triangle is computed.
+	MatrixTypeDoublePrecision ComputeCovarianceMatrix(const DataMatrixSource& X0) const;
+
+	// returns X0 A
+	MatrixTypeDoublePrecision Times(const DataMatrixSource& X0, const MatrixTypeDoublePrecision& A) const;
+
+	// computes X0^T A. The result is written block by block of rows, such that it can be a single precision matrix
+	// without a double precision copy of the whole product.
+	template <typename ResultMatrixType>
+	void TransposeTimes(const DataMatrixSource& X0, const MatrixTypeDoublePrecision& A, ResultMatrixType& result) const;
+
+	// replaces the columns of A by an orthonormal basis of their span
+	static void Orthonormalize(MatrixTypeDoublePrecision& A);
+
+	// returns the number of components that are kept, given the variances in descending order and the total variance of the data
+	unsigned GetNumberOfComponentsToKeep(const VectorTypeDoublePrecision& variances, double totalVariance, unsigned rank, double noiseVariance) const;
 
+	SolverType m_solverType;
+	unsigned m_maxNumberOfComponents;
+	double m_varianceRetained;
+	double m_memoryLimitInMB;
+	unsigned m_numberOfThreads;
 
 };
 
@@ -36,9 +36,13 @@
  */
 
 #include <Eigen/SVD>
+#include <Eigen/Eigenvalues>
+#include <Eigen/QR>
 #include "CommonTypes.h"
 #include "Exceptions.h"
+#include "MixedPrecision.h"
 #include <iostream>
+#include <limits>
 
 
 
@@ -48,8 +52,13 @@ namespace statismo {
 
 
 template <typename Representer>
-PCAModelBuilder<Representer>::PCAModelBuilder()
-: Superclass()
+PCAModelBuilder<Representer>::PCAModelBuilder(SolverType solverType)
+: Superclass(),
+  m_solverType(solverType),
+  m_maxNumberOfComponents(std::numeric_limits<unsigned>::max()),
+  m_varianceRetained(1.0),
+  m_memoryLimitInMB(0),
+  m_numberOfThreads(0)
   {}
 
 
@@ -66,33 +75,52 @@ PCAModelBuilder<Representer>::BuildNewModel(const SampleDataStructureListType& s
 	unsigned p = sampleDataList.front()->GetSampleVector().rows();
 	const Representer* representer = sampleDataList.front()->GetRepresenter();
 
-	// Build the sample matrix X
-	MatrixType X(n, p);
-
-	unsigned i = 0;
+	// The samples are not copied into a sample matrix. We only collect the sample vectors and compute the mean
+	// (in double precision). The centered data is then read from the samples block by block.
+	std::vector<const VectorType*> sampleVectors;
+	sampleVectors.reserve(n);
+	VectorTypeDoublePrecision sum = VectorTypeDoublePrecision::Zero(p);
 	for (typename SampleDataStructureListType::const_iterator it = sampleDataList.begin();
 		it != sampleDataList.end();
 		++it)
 	{
 		assert ((*it)->GetSampleVector().rows() == p); // all samples must have same number of rows
 		assert ((*it)->GetRepresenter() == representer); // all samples have the same representer
-		X.row(i++) = (*it)->GetSampleVector();
+		sampleVectors.push_back(&(*it)->GetSampleVector());
+		sum += (*it)->GetSampleVector().template cast<double>();
 	}
+	VectorType mean = (sum / n).cast<ScalarType>();
+	SampleVectorListSource X0(sampleVectors, mean);
 
 
 	// build the model
-	StatisticalModelType* model = BuildNewModelInternal(representer, X, noiseVariance);
+	SolverType solverType;
+	DecompositionType decompositionType;
+	ChooseMethod(n, p, solverType, decompositionType);
+	StatisticalModelType* model = BuildNewModelInternal(representer, X0, mean, noiseVariance, solverType, decompositionType);
+
+	// the scores are computed for a block of samples at a time
 	MatrixType scores;
 	if (computeScores) {
-		scores = this->ComputeScores(X, model);
+		scores.resize(model->GetNumberOfPrincipalComponents(), n);
+		MatrixType X;
+		for (unsigned i = 0; i < n; i += MixedPrecision::BLOCK_SIZE) {
+			unsigned nRows = std::min<unsigned>(MixedPrecision::BLOCK_SIZE, n - i);
+			X.resize(nRows, p);
+			for (unsigned j = 0; j < nRows; j++) {
+				X.row(j) = *sampleVectors[i + j];
+			}
+			scores.middleCols(i, nRows) = this->ComputeScores(X, model);
+		}
 	}
 
 
 	typename BuilderInfo::ParameterInfoList bi;
 	bi.push_back(BuilderInfo::KeyValuePair("NoiseVariance ", Utils::toString(noiseVariance)));
+	bi.push_back(BuilderInfo::KeyValuePair("Method ", GetMethodName(solverType, decompositionType)));
 
 	typename BuilderInfo::DataInfoList dataInfo;
-	i = 0;
+	unsigned i = 0;
 	for (typename SampleDataStructureListType::const_iterator it = sampleDataList.begin();
 		it != sampleDataList.end();
 		++it, i++)
@@ -118,79 +146,356 @@ PCAModelBuilder<Representer>::BuildNewModel(const SampleDataStructureListType& s
 
 template <typename Representer>
 typename PCAModelBuilder<Representer>::StatisticalModelType*
-PCAModelBuilder<Representer>::BuildNewModelInternal(const Representer* representer, const MatrixType& X, double noiseVariance) const
+PCAModelBuilder<Representer>::BuildNewModelInternal(const Representer* representer, const DataMatrixSource& X0, const VectorType& mean,
+		double noiseVariance, SolverType solverType, DecompositionType decompositionType) const
 {
 
-	typedef Eigen::JacobiSVD<MatrixType> SVDType;
-	typedef Eigen::JacobiSVD<MatrixTypeDoublePrecision> SVDDoublePrecisionType;
+	unsigned n = X0.GetNumberOfRows();
+	unsigned p = X0.GetNumberOfColumns();
+
+	// there can be at most n-1 nonzero eigenvalues, as the data is centered. Everything else must be due to numerical inaccuracies
+	unsigned rank = std::min(n - 1, p);
 
-	unsigned n = X.rows();
-	unsigned p = X.cols();
+	// the total variance is the trace of the covariance matrix. It is needed to find the number of components
+	// that explain a given fraction of the variance.
+	double totalVariance = ComputeSquaredNorm(X0) / (n - 1);
 
-	RowVectorType mu = X.colwise().mean(); // needs to be row vector
-	MatrixType X0 = X.rowwise() - mu;
+	VectorTypeDoublePrecision eigenvalues;
+	MatrixType pcaBasis;
+	unsigned numComponentsToKeep = 0;
+
+	if (decompositionType == DATA_MATRIX) {
+		unsigned maxNumberOfComponents = std::min(m_maxNumberOfComponents, rank);
+
+		// if only a fraction of the variance is needed, we start with a few components and double their number,
+		// until the fraction is explained
+		unsigned numberOfComponents = maxNumberOfComponents;
+		if (m_varianceRetained < 1) {
+			numberOfComponents = std::min(unsigned(RANDOMIZED_SVD_OVERSAMPLING), maxNumberOfComponents);
+		}
+
+		MatrixTypeDoublePrecision eigenvectors;
+		while (numberOfComponents > 0) {
+			ComputeRandomizedPCA(X0, numberOfComponents, eigenvalues, eigenvectors);
+			if (numberOfComponents == maxNumberOfComponents || eigenvalues.sum() >= m_varianceRetained * totalVariance) {
+				break;
+			}
+			numberOfComponents = std::min(2 * numberOfComponents, maxNumberOfComponents);
+		}
+		numComponentsToKeep = GetNumberOfComponentsToKeep(eigenvalues, totalVariance, rank, noiseVariance);
+		pcaBasis = eigenvectors.leftCols(numComponentsToKeep).cast<ScalarType>();
+	}
 
-	// We destinguish the case where we have more variables than samples and
-	// the case where we have more samples than variable.
-	// In the first case we compute the (smaller) inner product matrix instead of the full covariance matrix.
-	// It is known that this has the same non-zero singular values as the covariance matrix.
+	// Otherwise, we decompose either the inner product matrix or the covariance matrix, depending on which is cheaper
+	// (usually the inner product matrix if there are more variables than samples).
+	// The inner product matrix has the same non-zero eigenvalues as the covariance matrix.
 	// Furthermore, it is possible to compute the corresponding eigenvectors of the covariance matrix from the
 	// decomposition.
+	else if (decompositionType == INNER_PRODUCT_MATRIX) {
+		// we compute the eigenvectors of the covariance matrix by computing an eigendecomposition of the
+		// n x n inner product matrix 1/(n-1) X0X0^T, which is accumulated in double precision
+		MatrixTypeDoublePrecision Cov = ComputeInnerProductMatrix(X0) / (n-1);
+		MatrixTypeDoublePrecision V;
+		PCAKernels::ComputeEigenDecomposition(Cov, solverType == JACOBI_SVD, eigenvalues, V);
 
-	if (n < p) {
-		// we compute the eigenvectors of the covariance matrix by computing an SVD of the
-		// n x n inner product matrix 1/(n-1) X0X0^T
-		MatrixType Cov = X0 * X0.transpose() * 1.0/(n-1);
-		SVDDoublePrecisionType SVD(Cov.cast<double>(), Eigen::ComputeThinV);
-		VectorType singularValues = SVD.singularValues().cast<ScalarType>();
-		MatrixType V = SVD.matrixV().cast<ScalarType>();
+		numComponentsToKeep = GetNumberOfComponentsToKeep(eigenvalues, totalVariance, rank, noiseVariance);
 
-		unsigned numComponentsAboveTolerance = ((singularValues.array() - noiseVariance - Superclass::TOLERANCE) > 0).count();
-
-		// there can be at most n-1 nonzero singular values in this case. Everything else must be due to numerical inaccuracies
-		unsigned numComponentsToKeep = std::min(numComponentsAboveTolerance, n - 1);
-		// compute the pseudo inverse of the square root of the singular values
+		// compute the inverse of the square root of the eigenvalues
 		// which is then needed to recompute the PCA basis
-		VectorType singSqrt = singularValues.array().sqrt();
-		VectorType singSqrtInv = VectorType::Zero(singSqrt.rows());
+		VectorTypeDoublePrecision singSqrtInv(numComponentsToKeep);
 		for (unsigned i = 0; i < numComponentsToKeep; i++) {
-				assert(singSqrt(i) > Superclass::TOLERANCE);
-				singSqrtInv(i) = 1.0 / singSqrt(i);
+			double singSqrt = std::sqrt(eigenvalues(i));
+			assert(singSqrt > Superclass::TOLERANCE);
+			singSqrtInv(i) = 1.0 / singSqrt;
 		}
 
 		// we recover the eigenvectors U of the full covariance matrix from the eigenvectors V of the inner product matrix.
 		// We use the fact that if we decompose X as X=UDV^T, then we get X^TX = UD^2U^T and XX^T = VD^2V^T (exploiting the orthogonormality
 		// of the matrix U and V from the SVD). The additional factor sqrt(n-1) is to compensate for the 1/sqrt(n-1) in the formula
-		// for the covariance matrix.
-		MatrixType pcaBasis = (X0.transpose() * V * singSqrtInv.asDiagonal() / sqrt(n-1.0)).topLeftCorner(p, numComponentsToKeep);;
+		// for the covariance matrix. Only the columns of the components that are kept are computed, and the basis
+		// is formed block by block of rows.
+		MatrixTypeDoublePrecision VScaled = V.leftCols(numComponentsToKeep) * singSqrtInv.asDiagonal() / sqrt(n-1.0);
+		TransposeTimes(X0, VScaled, pcaBasis);
+	}
+	else {
+		// we compute an eigendecomposition of the full p x p  covariance matrix 1/(n-1) X0^TX0 directly. As in the first case,
+		// it is accumulated in double precision
+		MatrixTypeDoublePrecision Cov = ComputeCovarianceMatrix(X0) / (n-1);
+		MatrixTypeDoublePrecision U;
+		PCAKernels::ComputeEigenDecomposition(Cov, solverType == JACOBI_SVD, eigenvalues, U);
+
+		numComponentsToKeep = GetNumberOfComponentsToKeep(eigenvalues, totalVariance, rank, noiseVariance);
+		pcaBasis = U.leftCols(numComponentsToKeep).cast<ScalarType>();
+	}
+
+	if (numComponentsToKeep == 0) {
+		throw StatisticalModelException("All the eigenvalues are below the given tolerance. Model cannot be built.");
+	}
+
+	VectorType pcaVariance = (eigenvalues.topRows(numComponentsToKeep).array() - noiseVariance).cast<ScalarType>();
+
+	StatisticalModelType* model = StatisticalModelType::Create(representer, mean, pcaBasis, pcaVariance, noiseVariance);
+	return model;
+}
+
 
-		if (numComponentsToKeep == 0) {
-			throw StatisticalModelException("All the eigenvalues are below the given tolerance. Model cannot be built.");
+template <typename Representer>
+void
+PCAModelBuilder<Representer>::ChooseMethod(unsigned n, unsigned p, SolverType& solverType, DecompositionType& decompositionType) const
+{
+	if (m_solverType == RANDOMIZED_SVD) {
+		solverType = RANDOMIZED_SVD;
+		decompositionType = DATA_MATRIX;
+		return;
+	}
+
+	// the candidates are the decompositions of the inner product and the covariance matrix, and, if the
+	// number of components is known in advance and smaller than the rank, the randomized SVD
+	std::vector<std::pair<SolverType, DecompositionType> > candidates;
+	SolverType eigenSolverType = (m_solverType == JACOBI_SVD) ? JACOBI_SVD : SELF_ADJOINT_EIGEN_SOLVER;
+	candidates.push_back(std::make_pair(eigenSolverType, INNER_PRODUCT_MATRIX));
+	candidates.push_back(std::make_pair(eigenSolverType, COVARIANCE_MATRIX));
+	if (m_solverType == AUTOMATIC && m_maxNumberOfComponents < std::min(n - 1, p)) {
+		candidates.push_back(std::make_pair(RANDOMIZED_SVD, DATA_MATRIX));
+	}
+
+	// we take the cheapest method within the memory limit, or the one that needs the least memory if none fits
+	double memoryLimit = m_memoryLimitInMB * 1024 * 1024;
+	double bestFlops = std::numeric_limits<double>::max();
+	double bestMemory = std::numeric_limits<double>::max();
+	bool bestFits = false;
+	for (unsigned i = 0; i < candidates.size(); i++) {
+		double flops, memory;
+		EstimateCost(n, p, candidates[i].first, candidates[i].second, flops, memory);
+		bool fits = (m_memoryLimitInMB <= 0 || memory <= memoryLimit);
+
+		bool isBetter = false;
+		if (fits) {
+			isBetter = !bestFits || flops < bestFlops;
+		}
+		else {
+			isBetter = !bestFits && memory < bestMemory;
 		}
 
-		VectorType sampleVarianceVector = singularValues.topRows(numComponentsToKeep);
-		VectorType pcaVariance = (sampleVarianceVector - VectorType::Ones(numComponentsToKeep) * noiseVariance);
+		if (isBetter) {
+			solverType = candidates[i].first;
+			decompositionType = candidates[i].second;
+			bestFlops = flops;
+			bestMemory = memory;
+			bestFits = fits;
+		}
+	}
+}
 
-		StatisticalModelType* model = StatisticalModelType::Create(representer, mu, pcaBasis, pcaVariance, noiseVariance);
 
-		return model;
+template <typename Representer>
+void
+PCAModelBuilder<Representer>::EstimateCost(unsigned n, unsigned p, SolverType solverType, DecompositionType decompositionType, double& flops, double& memory) const
+{
+	// the estimates count multiply-add operations and the bytes of the double precision temporaries. The data itself and
+	// the resulting basis are needed by all the methods and are therefore not counted.
+	// The factors for the eigendecompositions of an m x m matrix (c m^3) are rough estimates for the tridiagonalization
+	// followed by the QR iterations, and for the one-sided Jacobi sweeps.
+	const double selfAdjointEigenSolverFactor = 9;
+	const double jacobiSVDFactor = 30;
+	double eigenFactor = (solverType == JACOBI_SVD) ? jacobiSVDFactor : selfAdjointEigenSolverFactor;
+
+	double nd = n;
+	double pd = p;
+	double k = std::min(m_maxNumberOfComponents, std::min(n - 1, p));
+
+	switch (decompositionType) {
+	case INNER_PRODUCT_MATRIX:
+		// forming (the lower triangle of) X0 X0^T, the decomposition and the reconstruction of the basis X0^T V
+		flops = nd * nd * pd / 2 + eigenFactor * nd * nd * nd + nd * pd * k;
+		memory = 2 * sizeof(double) * nd * nd;
+		break;
+	case COVARIANCE_MATRIX:
+		// forming (the lower triangle of) X0^T X0 and the decomposition
+		flops = nd * pd * pd / 2 + eigenFactor * pd * pd * pd;
+		memory = 2 * sizeof(double) * pd * pd;
+		break;
+	case DATA_MATRIX: {
+		// the products with X0 and X0^T and the orthonormalizations of the n x l and p x l matrices
+		double l = std::min(k + RANDOMIZED_SVD_OVERSAMPLING, std::min(nd, pd));
+		double q = RANDOMIZED_SVD_POWER_ITERATIONS;
+		flops = (2 * q + 3) * nd * pd * l + (2 * q + 2) * (nd + pd) * l * l + selfAdjointEigenSolverFactor * l * l * l;
+		memory = sizeof(double) * (nd + 2 * pd) * l;
+		break;
 	}
-	else {
-		// we compute an SVD of the full p x p  covariance matrix 1/(n-1) X0^TX0 directly
-		SVDType SVD(X0.transpose() * X0 * 1.0/(n-1), Eigen::ComputeThinU);
-		VectorType singularValues = SVD.singularValues();
-		unsigned numComponentsToKeep = ((singularValues.array() - noiseVariance - Superclass::TOLERANCE) > 0).count();
-		MatrixType pcaBasis = SVD.matrixU().topLeftCorner(p, numComponentsToKeep);
-
-		if (numComponentsToKeep == 0) {
-			throw StatisticalModelException("All the eigenvalues are below the given tolerance. Model cannot be built.");
+	default:
+		throw StatisticalModelException("Unknown decomposition type in PCAModelBuilder::EstimateCost");
+	}
+}
+
+
+template <typename Representer>
+std::string
+PCAModelBuilder<Representer>::GetMethodName(SolverType solverType, DecompositionType decompositionType)
+{
+	std::string solverName;
+	switch (solverType) {
+	case JACOBI_SVD: solverName = "JacobiSVD"; break;
+	case SELF_ADJOINT_EIGEN_SOLVER: solverName = "SelfAdjointEigenSolver"; break;
+	case RANDOMIZED_SVD: solverName = "RandomizedSVD"; break;
+	default: solverName = "Unknown";
+	}
+
+	std::string matrixName;
+	switch (decompositionType) {
+	case INNER_PRODUCT_MATRIX: matrixName = "InnerProductMatrix"; break;
+	case COVARIANCE_MATRIX: matrixName = "CovarianceMatrix"; break;
+	case DATA_MATRIX: matrixName = "DataMatrix"; break;
+	}
+	return solverName + "(" + matrixName + ")";
+}
+
+
+template <typename Representer>
+void
+PCAModelBuilder<Representer>::ComputeRandomizedPCA(const DataMatrixSource& X0, unsigned numberOfComponents, VectorTypeDoublePrecision& eigenvalues, MatrixTypeDoublePrecision& eigenvectors) const
+{
+	unsigned n = X0.GetNumberOfRows();
+	unsigned p = X0.GetNumberOfColumns();
+	unsigned l = std::min(numberOfComponents + RANDOMIZED_SVD_OVERSAMPLING, std::min(n, p));
+
+	// the random test matrix is always drawn with the same seed, such that the builds are reproducible
+	RandomStream stream(0);
+	MatrixTypeDoublePrecision Z = Utils::generateNormalMatrix(p, l, stream).cast<double>();
+
+	// The range finder computes an orthonormal basis Q of the range of X0 Omega. Each power iteration
+	// multiplies by X0 X0^T, which damps the directions with small variance.
+	MatrixTypeDoublePrecision Q = Times(X0, Z);
+	Orthonormalize(Q);
+	for (unsigned i = 0; i < RANDOMIZED_SVD_POWER_ITERATIONS; i++) {
+		TransposeTimes(X0, Q, Z);
+		Orthonormalize(Z);
+		Q = Times(X0, Z);
+		Orthonormalize(Q);
+	}
+
+	// The small matrix B = Q^T X0 = Z^T (with Z = X0^T Q) has approximately the same leading singular values and
+	// right singular vectors as X0. With B = W S V^T, we have B B^T = W S^2 W^T and V = B^T W S^{-1}.
+	TransposeTimes(X0, Q, Z);
+	MatrixTypeDoublePrecision BBt = Z.transpose() * Z;
+
+	VectorTypeDoublePrecision S2;
+	MatrixTypeDoublePrecision W;
+	PCAKernels::ComputeEigenDecomposition(BBt, false, S2, W);
+
+	unsigned k = std::min(numberOfComponents, l);
+	eigenvalues = S2.topRows(k) / (n - 1);
+	VectorTypeDoublePrecision SInv = VectorTypeDoublePrecision::Zero(k);
+	for (unsigned i = 0; i < k; i++) {
+		if (S2(i) > Superclass::TOLERANCE) {
+			SInv(i) = 1.0 / std::sqrt(S2(i));
 		}
+	}
+	eigenvectors = Z * (W.leftCols(k) * SInv.asDiagonal());
+}
+
 
-		VectorType sampleVarianceVector = singularValues.topRows(numComponentsToKeep);
-		VectorType pcaVariance = (sampleVarianceVector - VectorType::Ones(numComponentsToKeep) * noiseVariance);
-		StatisticalModelType* model = StatisticalModelType::Create(representer, mu, pcaBasis, pcaVariance, noiseVariance);
-		return model;
+template <typename Representer>
+double
+PCAModelBuilder<Representer>::ComputeSquaredNorm(const DataMatrixSource& X0)
+{
+	double squaredNorm = 0;
+	MatrixTypeDoublePrecision block;
+	for (unsigned i = 0; i < X0.GetNumberOfRows(); i += MixedPrecision::BLOCK_SIZE) {
+		unsigned nRows = std::min<unsigned>(MixedPrecision::BLOCK_SIZE, X0.GetNumberOfRows() - i);
+		X0.GetCenteredRows(i, nRows, block);
+		squaredNorm += block.squaredNorm();
+	}
+	return squaredNorm;
+}
+
+
+template <typename Representer>
+MatrixTypeDoublePrecision
+PCAModelBuilder<Representer>::ComputeInnerProductMatrix(const DataMatrixSource& X0) const
+{
+	unsigned n = X0.GetNumberOfRows();
+	MatrixTypeDoublePrecision result = MatrixTypeDoublePrecision::Zero(n, n);
+	MatrixTypeDoublePrecision block;
+	for (unsigned j = 0; j < X0.GetNumberOfColumns(); j += MixedPrecision::BLOCK_SIZE) {
+		unsigned nCols = std::min<unsigned>(MixedPrecision::BLOCK_SIZE, X0.GetNumberOfColumns() - j);
+		X0.GetCenteredColumns(j, nCols, block);
+		PCAKernels::AddLowerTriangleOfTimesTransposeSelf(block, result, m_numberOfThreads);
+	}
+	PCAKernels::CopyLowerToUpperTriangle(result);
+	return result;
+}
+
+
+template <typename Representer>
+MatrixTypeDoublePrecision
+PCAModelBuilder<Representer>::ComputeCovarianceMatrix(const DataMatrixSource& X0) const
+{
+	unsigned p = X0.GetNumberOfColumns();
+	MatrixTypeDoublePrecision result = MatrixTypeDoublePrecision::Zero(p, p);
+	MatrixTypeDoublePrecision block;
+	MatrixTypeDoublePrecision blockTransposed;
+	for (unsigned i = 0; i < X0.GetNumberOfRows(); i += MixedPrecision::BLOCK_SIZE) {
+		unsigned nRows = std::min<unsigned>(MixedPrecision::BLOCK_SIZE, X0.GetNumberOfRows() - i);
+		X0.GetCenteredRows(i, nRows, block);
+		// the tiles read rows of the (row major) transposed block, i.e. contiguous memory
+		blockTransposed = block.transpose();
+		PCAKernels::AddLowerTriangleOfTimesTransposeSelf(blockTransposed, result, m_numberOfThreads);
 	}
+	PCAKernels::CopyLowerToUpperTriangle(result);
+	return result;
+}
+
+
+template <typename Representer>
+MatrixTypeDoublePrecision
+PCAModelBuilder<Representer>::Times(const DataMatrixSource& X0, const MatrixTypeDoublePrecision& A) const
+{
+	assert(A.rows() == X0.GetNumberOfColumns());
+	unsigned n = X0.GetNumberOfRows();
+	MatrixTypeDoublePrecision result = MatrixTypeDoublePrecision::Zero(n, A.cols());
+	MatrixTypeDoublePrecision block;
+	for (unsigned j = 0; j < X0.GetNumberOfColumns(); j += MixedPrecision::BLOCK_SIZE) {
+		unsigned nCols = std::min<unsigned>(MixedPrecision::BLOCK_SIZE, X0.GetNumberOfColumns() - j);
+		X0.GetCenteredColumns(j, nCols, block);
+		PCAKernels::AddTimes(block, A.middleRows(j, nCols), result, m_numberOfThreads);
+	}
+	return result;
+}
+
+
+template <typename Representer>
+template <typename ResultMatrixType>
+void
+PCAModelBuilder<Representer>::TransposeTimes(const DataMatrixSource& X0, const MatrixTypeDoublePrecision& A, ResultMatrixType& result) const
+{
+	assert(A.rows() == X0.GetNumberOfRows());
+	result.resize(X0.GetNumberOfColumns(), A.cols());
+	MatrixTypeDoublePrecision block;
+	for (unsigned j = 0; j < X0.GetNumberOfColumns(); j += MixedPrecision::BLOCK_SIZE) {
+		unsigned nCols = std::min<unsigned>(MixedPrecision::BLOCK_SIZE, X0.GetNumberOfColumns() - j);
+		X0.GetCenteredColumns(j, nCols, block);
+		// the rows j, ..., j + nCols - 1 of the result
+		PCAKernels::TransposeTimesIntoRows(block, A, j, result, m_numberOfThreads);
+	}
+}
+
+
+template <typename Representer>
+void
+PCAModelBuilder<Representer>::Orthonormalize(MatrixTypeDoublePrecision& A)
+{
+	Eigen::HouseholderQR<MatrixTypeDoublePrecision> qr(A);
+	A = qr.householderQ() * MatrixTypeDoublePrecision::Identity(A.rows(), A.cols());
+}
+
+
+template <typename Representer>
+unsigned
+PCAModelBuilder<Representer>::GetNumberOfComponentsToKeep(const VectorTypeDoublePrecision& variances, double totalVariance, unsigned rank, double noiseVariance) const
+{
+	return PCAKernels::GetNumberOfComponentsToKeep(variances, totalVariance, rank, noiseVariance,
+			m_maxNumberOfComponents, m_varianceRetained, Superclass::TOLERANCE);
 }
 
 
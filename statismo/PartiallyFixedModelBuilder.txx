@@ -38,6 +38,7 @@
 #include <Eigen/SVD>
 #include "CommonTypes.h"
 #include "PCAModelBuilder.h"
+#include "MixedPrecision.h"
 
 #include <iostream>
 
@@ -81,7 +82,7 @@ PartiallyFixedModelBuilder<Representer>::BuildNewModelFromModel(
 
 	const Representer* representer = inputModel->GetRepresenter();
 
-	const MatrixType& pcaBasisMatrix =  inputModel->GetOrthonormalPCABasisMatrix();
+	ConstScaledMatrixViewType pcaBasisMatrix = inputModel->GetOrthonormalPCABasisMatrix();
 	const VectorType& meanVector = inputModel->GetMeanVector();
 
 	// this method only makes sense for a proper PPCA model (e.g. the noise term is properly defined)
@@ -119,16 +120,16 @@ PartiallyFixedModelBuilder<Representer>::BuildNewModelFromModel(
 	// the names of the matrices are those used in Bishop, Pattern recognition and Machine learning (PRML),
 	// chapter 12, on which this implementation is based.
 	const MatrixType& W = PCABasisPart * D.asDiagonal();
-	const MatrixType& WT = W.transpose();
 
-	MatrixType M = WT * W;
-	M.diagonal() += pointValuesNoiseVariance * VectorType::Ones(W.cols());
+	// M and the right hand side are accumulated in double precision, as the system is often badly
+	// conditioned when only a few points are given
+	MatrixTypeDoublePrecision M = MixedPrecision::TransposeTimesSelf(W);
+	M.diagonal().array() += pointValuesNoiseVariance;
 
-
-	MatrixTypeDoublePrecision Minv = M.cast<double>().inverse();
+	MatrixTypeDoublePrecision Minv = M.inverse();
 
 	// the MAP solution for the latent variables (coefficients)
-	VectorType coeffs = Minv.cast<ScalarType>() * WT * (samplePart - muPart);
+	VectorType coeffs = (Minv * MixedPrecision::TransposeTimes(W, samplePart - muPart)).cast<ScalarType>();
 
 	// the MAP solution in the sample space
 	VectorType newMean = inputModel->GetRepresenter()->SampleToSampleVector(inputModel->DrawSample(coeffs));
@@ -166,7 +167,9 @@ PartiallyFixedModelBuilder<Representer>::BuildNewModelFromModel(
 
 	VectorType newPCAVariance = svd.singularValues().cast<ScalarType>();
 
-	MatrixType newPCABasisMatrix = pcaBasisMatrix * svd.matrixU().cast<ScalarType>();
+	// as U = W D^{-1/2}, the scaling is applied to the small matrix Uhat, such that the orthonormal basis is never copied
+	MatrixTypeDoublePrecision scaledUhat = pcaSdev.cwiseInverse().asDiagonal() * svd.matrixU();
+	MatrixType newPCABasisMatrix = inputModel->GetPCABasisMatrixView() * scaledUhat.cast<ScalarType>();
 
 	StatisticalModelType* partiallyFixedModel = StatisticalModelType::Create(representer,newMean, newPCABasisMatrix, newPCAVariance, noiseVariance);
 
@@ -209,13 +212,10 @@ PartiallyFixedModelBuilder<Representer>::BuildNewModelFromModel(
 
 	if (computeScores == true) {
 
-		// get the scores from the input model
-		for (unsigned i = 0; i < inputScores.cols(); i++) {
-			// reconstruct the sample from the input model and project it back into the model
-			typename Representer::DatasetPointerType ds = inputModel->DrawSample(inputScores.col(i));
-			scores.col(i) = partiallyFixedModel->ComputeCoefficientsForDataset(ds);
-			Representer::DeleteDataset(ds);
-		}
+		// reconstruct the samples from the scores of the input model and project them all at once into the new model
+		MatrixType inputSamples = (inputModel->GetPCABasisMatrixView() * inputScores).transpose();
+		inputSamples.rowwise() += inputModel->GetMeanVector().transpose();
+		scores = this->ComputeScores(inputSamples, partiallyFixedModel);
 	}
 	ModelInfo info(scores, builderInfoList);
 	partiallyFixedModel->SetModelInfo(info);
@@ -0,0 +1,162 @@
+/*
+ * This file is part of the statismo library.
+ *
+ * Author: Marcel Luethi (marcel.luethi@unibas.ch)
+ *
+ * Copyright (c) 2011 University of Basel
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ *
+ * Neither the name of the project's author nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+ * TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS addINTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#ifndef __POSTERIORSESSION_H_
+#define __POSTERIORSESSION_H_
+
+#include "Config.h"
+#include "StatisticalModel.h"
+#include "CommonTypes.h"
+#include <map>
+
+namespace statismo {
+
+
+/**
+ * \brief Incrementally computes the coefficients of a model, given a changing set of known point values.
+ *
+ * This class computes the same coefficients as StatisticalModel::ComputeCoefficientsForPointIDValues, but is
+ * designed for interactive applications, where the known values (e.g. landmarks) are added, moved or removed one at a time.
+ * Instead of solving the system \f$M \alpha = B^T (s - \mu)\f$, with \f$M = B^T B + \sigma^2 I\f$, from scratch for each change,
+ * the session keeps the cholesky factor of \f$M\f$ and the right hand side up to date:
+ * - Adding or removing a point corresponds to a rank d update or downdate of the factor (\f$O(dk^2)\f$).
+ * - Moving a point only changes the right hand side (\f$O(dk)\f$).
+ * The coefficients are then obtained by a forward and backward substitution (\f$O(k^2)\f$).
+ *
+ * For mathematical details, see the paper
+ * Probabilistic Modeling and Visualization of the Flexibility in Morphable Models,
+ * M. Luethi, T. Albrecht and T. Vetter, Mathematics of Surfaces, 2009
+ *
+ * \warning The session only references the model. The model must not be deleted as long as the session is in use.
+ */
+template <typename Representer>
+class PosteriorSession {
+public:
+
+	typedef StatisticalModel<Representer> StatisticalModelType;
+	typedef typename Representer::ValueType ValueType;
+	typedef typename Representer::DatasetPointerType DatasetPointerType;
+
+	/**
+	 * Factory method that creates a new session without any known point values
+	 * \param model The statistical model
+	 * \param pointValueNoiseVariance The variance of estimated (gaussian) noise at the known points
+	 */
+	static PosteriorSession* Create(const StatisticalModelType* model, double pointValueNoiseVariance = 0.0) {
+		return new PosteriorSession(model, pointValueNoiseVariance);
+	}
+
+	/**
+	 * Destroy the object.
+	 * The same effect can be achieved by deleting the object in the usual
+	 * way using the c++ delete keyword.
+	 */
+	void Delete() const { delete this; }
+
+	/**
+	 * Destructor
+	 */
+	virtual ~PosteriorSession() {}
+
+	/**
+	 * Adds a known value for the point with the given id. An exception is thrown if the point already has a value.
+	 */
+	void AddPointValue(unsigned ptId, const ValueType& value);
+
+	/**
+	 * Changes the value for the point with the given id. An exception is thrown if the point has no value.
+	 */
+	void SetPointValue(unsigned ptId, const ValueType& value);
+
+	/**
+	 * Removes the value for the point with the given id. An exception is thrown if the point has no value.
+	 */
+	void RemovePointValue(unsigned ptId);
+
+	/**
+	 * \return The number of points, for which a value is known
+	 */
+	unsigned GetNumberOfPointValues() const { return m_pointValues.size(); }
+
+	/**
+	 * Returns the coefficients of the latent variables, given the known point values.
+	 * \sa StatisticalModel::ComputeCoefficientsForPointIDValues
+	 */
+	VectorType GetCoefficients() const;
+
+	/**
+	 * Returns the sample, that corresponds to the coefficients given by GetCoefficients.
+	 * This is the mean of the posterior distribution, given the known point values.
+	 */
+	DatasetPointerType DrawPosteriorMean() const;
+
+private:
+
+	typedef std::map<unsigned, VectorType> PointValueMapType;
+
+	PosteriorSession(const StatisticalModelType* model, double pointValueNoiseVariance);
+
+	// to prevent use
+	PosteriorSession(const PosteriorSession& orig);
+	PosteriorSession& operator=(const PosteriorSession& rhs);
+
+	// updates the factor L, such that L L^T + sign * v v^T = L' L'^T. Returns false if the result is not positive definite
+	static bool CholeskyRankOneUpdate(MatrixTypeDoublePrecision& L, VectorTypeDoublePrecision v, double sign);
+
+	// updates the factor and the right hand side for all the components of the point. sign is 1 for adding and -1 for removing a point.
+	void UpdateFactorization(unsigned ptId, const VectorType& value, double sign);
+
+	// recomputes the factorization from scratch, using all the current point values
+	void Refactorize();
+
+	const StatisticalModelType* m_model;
+	double m_noiseVariance;
+
+	PointValueMapType m_pointValues;
+
+	// lower triangular cholesky factor of M = B^T B + sigma^2 I and the right hand side B^T (s - mu)
+	MatrixTypeDoublePrecision m_L;
+	VectorTypeDoublePrecision m_rhs;
+};
+
+
+} // namespace statismo
+
+#include "PosteriorSession.txx"
+
+#endif /* __POSTERIORSESSION_H_ */
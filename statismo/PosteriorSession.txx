@@ -0,0 +1,200 @@
+/*
+ * This file is part of the statismo library.
+ *
+ * Author: Marcel Luethi (marcel.luethi@unibas.ch)
+ *
+ * Copyright (c) 2011 University of Basel
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ *
+ * Neither the name of the project's author nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+ * TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS addINTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#include "PosteriorSession.h"
+#include "ModelBuilder.h"
+#include "Exceptions.h"
+#include <cmath>
+
+namespace statismo {
+
+
+template <typename Representer>
+PosteriorSession<Representer>::PosteriorSession(const StatisticalModelType* model, double pointValueNoiseVariance)
+: m_model(model)
+{
+	// the system is only guaranteed to be positive definite for positive noise. If the model has zero noise,
+	// we assume a small amount of noise (c.f. PartiallyFixedModelBuilder)
+	m_noiseVariance = std::max(pointValueNoiseVariance, (double) model->GetNoiseVariance());
+	m_noiseVariance = std::max(m_noiseVariance, ModelBuilder<Representer>::TOLERANCE);
+
+	Refactorize();
+}
+
+
+template <typename Representer>
+void
+PosteriorSession<Representer>::AddPointValue(unsigned ptId, const ValueType& value) {
+
+	if (m_pointValues.find(ptId) != m_pointValues.end()) {
+		throw StatisticalModelException("A value for the given point id was already added to the PosteriorSession");
+	}
+
+	VectorType v = m_model->GetRepresenter()->PointSampleToPointSampleVector(value);
+	UpdateFactorization(ptId, v, 1);
+	m_pointValues[ptId] = v;
+}
+
+
+template <typename Representer>
+void
+PosteriorSession<Representer>::SetPointValue(unsigned ptId, const ValueType& value) {
+
+	typename PointValueMapType::iterator it = m_pointValues.find(ptId);
+	if (it == m_pointValues.end()) {
+		throw StatisticalModelException("The PosteriorSession has no value for the given point id");
+	}
+
+	// the system matrix only depends on the points, not on their values. Only the right hand side changes.
+	VectorType v = m_model->GetRepresenter()->PointSampleToPointSampleVector(value);
+	ConstMatrixViewType W = m_model->GetPCABasisMatrixView();
+	for (unsigned d = 0; d < RepresenterTraits<Representer>::GetDimensions(); d++) {
+		unsigned idx = Representer::MapPointIdToInternalIdx(ptId, d);
+		m_rhs += W.row(idx).transpose().cast<double>() * (double(v[d]) - it->second[d]);
+	}
+	it->second = v;
+}
+
+
+template <typename Representer>
+void
+PosteriorSession<Representer>::RemovePointValue(unsigned ptId) {
+
+	typename PointValueMapType::iterator it = m_pointValues.find(ptId);
+	if (it == m_pointValues.end()) {
+		throw StatisticalModelException("The PosteriorSession has no value for the given point id");
+	}
+
+	VectorType v = it->second;
+	m_pointValues.erase(it);
+	UpdateFactorization(ptId, v, -1);
+}
+
+
+template <typename Representer>
+VectorType
+PosteriorSession<Representer>::GetCoefficients() const {
+	VectorTypeDoublePrecision y = m_L.triangularView<Eigen::Lower>().solve(m_rhs);
+	VectorTypeDoublePrecision coeffs = m_L.transpose().triangularView<Eigen::Upper>().solve(y);
+	return coeffs.cast<ScalarType>();
+}
+
+
+template <typename Representer>
+typename PosteriorSession<Representer>::DatasetPointerType
+PosteriorSession<Representer>::DrawPosteriorMean() const {
+	return m_model->DrawSample(GetCoefficients());
+}
+
+
+template <typename Representer>
+void
+PosteriorSession<Representer>::UpdateFactorization(unsigned ptId, const VectorType& value, double sign) {
+
+	typename StatisticalModelType::PointIdListType pointIds(1, ptId);
+	std::vector<unsigned> indices = m_model->MapPointIdsToInternalIndices(pointIds);
+
+	ConstMatrixViewType W = m_model->GetPCABasisMatrixView();
+	const VectorType& mean = m_model->GetMeanVector();
+
+	bool success = true;
+	for (unsigned d = 0; d < indices.size(); d++) {
+		VectorTypeDoublePrecision b = W.row(indices[d]).transpose().cast<double>();
+		m_rhs += sign * b * (double(value[d]) - mean[indices[d]]);
+		if (success) {
+			success = CholeskyRankOneUpdate(m_L, b, sign);
+		}
+	}
+
+	// a downdate can fail due to rounding errors. In this case we simply start from scratch.
+	if (success == false) {
+		Refactorize();
+	}
+}
+
+
+template <typename Representer>
+void
+PosteriorSession<Representer>::Refactorize() {
+
+	unsigned k = m_model->GetNumberOfPrincipalComponents();
+	ConstMatrixViewType W = m_model->GetPCABasisMatrixView();
+	const VectorType& mean = m_model->GetMeanVector();
+
+	MatrixTypeDoublePrecision M = MatrixTypeDoublePrecision::Identity(k, k) * m_noiseVariance;
+	m_rhs = VectorTypeDoublePrecision::Zero(k);
+
+	for (typename PointValueMapType::const_iterator it = m_pointValues.begin(); it != m_pointValues.end(); ++it) {
+		for (unsigned d = 0; d < RepresenterTraits<Representer>::GetDimensions(); d++) {
+			unsigned idx = Representer::MapPointIdToInternalIdx(it->first, d);
+			VectorTypeDoublePrecision b = W.row(idx).transpose().cast<double>();
+			M += b * b.transpose();
+			m_rhs += b * (double(it->second[d]) - mean[idx]);
+		}
+	}
+
+	Eigen::LLT<MatrixTypeDoublePrecision> llt(M);
+	m_L = llt.matrixL();
+}
+
+
+template <typename Representer>
+bool
+PosteriorSession<Representer>::CholeskyRankOneUpdate(MatrixTypeDoublePrecision& L, VectorTypeDoublePrecision v, double sign) {
+
+	// the classical algorithm for updating a cholesky factor with a vector v (see e.g. Golub, van Loan, Matrix Computations).
+	unsigned n = L.rows();
+	for (unsigned k = 0; k < n; k++) {
+		double r2 = L(k, k) * L(k, k) + sign * v(k) * v(k);
+		if (r2 <= 0) {
+			return false;
+		}
+		double r = std::sqrt(r2);
+		double c = r / L(k, k);
+		double s = v(k) / L(k, k);
+		L(k, k) = r;
+		for (unsigned i = k + 1; i < n; i++) {
+			L(i, k) = (L(i, k) + sign * s * v(i)) / c;
+			v(i) = c * v(i) - s * L(i, k);
+		}
+	}
+	return true;
+}
+
+
+} // namespace statismo
@@ -0,0 +1,231 @@
+/*
+ * This file is part of the statismo library.
+ *
+ * Author: Marcel Luethi (marcel.luethi@unibas.ch)
+ *
+ * Copyright (c) 2011 University of Basel
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ *
+ * Neither the name of the project's author nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+ * TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS addINTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#ifndef __QUANTIZEDSTATISTICALMODEL_H_
+#define __QUANTIZEDSTATISTICALMODEL_H_
+
+#include "Config.h"
+#include "StatisticalModel.h"
+#include "CommonTypes.h"
+#include <boost/cstdint.hpp>
+#include <string>
+#include <vector>
+
+namespace statismo {
+
+
+/**
+ * \brief A read only version of a StatisticalModel, whose PCA basis is stored with reduced precision.
+ *
+ * For models of high resolution meshes or images, the PCA basis (a \f$p \times k\f$ matrix) dominates the memory
+ * requirements, and the speed of most operations is limited by the memory bandwidth needed to read it.
+ * This class stores each column of the basis \f$W\f$ scaled by \f$s_j = \max_i |W_{ij}|\f$, either
+ * - as half precision floating point numbers (QUANTIZATION_FP16), which halves the memory, or
+ * - as 8 bit integers (QUANTIZATION_INT8), which needs four times less memory than the float basis.
+ *
+ * The basis is dequantized on the fly in the inner loops of the operations, i.e. it is never expanded in memory.
+ * The error of each entry of the basis is bounded by
+ * - \f$|\hat{W}_{ij} - W_{ij}| \le 2^{-11} s_j\f$ for QUANTIZATION_FP16, and
+ * - \f$|\hat{W}_{ij} - W_{ij}| \le s_j / 254\f$ for QUANTIZATION_INT8,
+ *
+ * (see GetQuantizationErrorBounds). Consequently, the error of a sample drawn with coefficients \f$\alpha\f$ is bounded by
+ * \f$\sum_j |\alpha_j| e_j\f$ at each entry, where \f$e_j\f$ denotes the error bound of the j-th column.
+ * The coefficients computed by ComputeCoefficientsForSampleVector are exact for the quantized model.
+ *
+ * A quantized model is either created from a StatisticalModel, or loaded directly from a model file. In the latter
+ * case, the basis is read block by block, and hence the full precision basis is never held in memory.
+ */
+template <typename Representer>
+class QuantizedStatisticalModel {
+public:
+
+	typedef StatisticalModel<Representer> StatisticalModelType;
+	typedef typename Representer::DatasetPointerType DatasetPointerType;
+	typedef typename Representer::DatasetConstPointerType DatasetConstPointerType;
+
+	enum QuantizationType {
+		QUANTIZATION_FP16,
+		QUANTIZATION_INT8
+	};
+
+	/**
+	 * Factory method that creates a quantized copy of the given model
+	 * \param model The statistical model
+	 * \param quantizationType The type used to store the PCA basis
+	 */
+	static QuantizedStatisticalModel* Create(const StatisticalModelType* model, QuantizationType quantizationType);
+
+	/**
+	 * Loads a statistical model from the given file and quantizes its PCA basis.
+	 * \param filename The name of the model file (see StatisticalModel::Save)
+	 * \param quantizationType The type used to store the PCA basis
+	 */
+	static QuantizedStatisticalModel* Load(const std::string& filename, QuantizationType quantizationType);
+
+	/**
+	 * Destroy the object.
+	 * The same effect can be achieved by deleting the object in the usual
+	 * way using the c++ delete keyword.
+	 */
+	void Delete() const { delete this; }
+
+	/**
+	 * Destructor
+	 */
+	virtual ~QuantizedStatisticalModel();
+
+	QuantizationType GetQuantizationType() const { return m_quantizationType; }
+
+	unsigned GetNumberOfPrincipalComponents() const { return m_columnScale.rows(); }
+
+	const VectorType& GetMeanVector() const { return m_mean; }
+
+	const VectorType& GetPCAVarianceVector() const { return m_pcaVariance; }
+
+	float GetNoiseVariance() const { return m_noiseVariance; }
+
+	const Representer* GetRepresenter() const { return m_representer; }
+
+	/**
+	 * \return For each column of the basis, an upper bound for the absolute error of its entries (see the class description)
+	 */
+	VectorType GetQuantizationErrorBounds() const;
+
+	/**
+	 * \return The number of bytes used to store the PCA basis
+	 */
+	std::size_t GetBasisMemorySize() const;
+
+	/**
+	 * Returns the sample vector \f$\mu + \hat{W} \alpha\f$ (c.f. StatisticalModel::DrawSampleVector)
+	 */
+	VectorType DrawSampleVector(const VectorType& coefficients) const;
+
+	/**
+	 * Returns the sample with the given coefficients as a new dataset (c.f. StatisticalModel::DrawSample)
+	 */
+	DatasetPointerType DrawSample(const VectorType& coefficients) const;
+
+	/**
+	 * Writes the value of the sample with the given coefficients at the given point to the buffer
+	 * (c.f. StatisticalModel::DrawSampleAtPointInto)
+	 */
+	void DrawSampleAtPointInto(const VectorType& coefficients, unsigned ptId, ScalarType* value) const;
+
+	/**
+	 * Returns the coefficients of the given sample vector (c.f. StatisticalModel::ComputeCoefficientsForSampleVector)
+	 */
+	VectorType ComputeCoefficientsForSampleVector(const VectorType& sample) const;
+
+	/**
+	 * Returns the coefficients of the given dataset (c.f. StatisticalModel::ComputeCoefficientsForDataset)
+	 */
+	VectorType ComputeCoefficientsForDataset(DatasetConstPointerType dataset) const;
+
+	/**
+	 * Converts a float to the nearest half precision (IEEE 754 binary16) number, including the subnormal numbers.
+	 * Values whose magnitude exceeds the largest half precision number 65504 are clamped to it.
+	 */
+	static boost::uint16_t FloatToHalf(float f);
+
+	/**
+	 * Converts a finite half precision number to a float (exactly). Infinity and NaN, which FloatToHalf never returns,
+	 * are not supported.
+	 */
+	static float HalfToFloat(boost::uint16_t h);
+
+private:
+
+	// the number of rows that are dequantized or read from a file at once. The constants are enums, such that
+	// std::min does not ODR-use them.
+	enum { BLOCK_SIZE = 1024 };
+
+	// the number of independent partial sums per row in DrawSampleKernel (one vector register of floats with AVX)
+	enum { NUMBER_OF_ACCUMULATORS = 8 };
+
+	QuantizedStatisticalModel(const Representer* representer, QuantizationType quantizationType);
+
+	// to prevent use
+	QuantizedStatisticalModel(const QuantizedStatisticalModel& orig);
+	QuantizedStatisticalModel& operator=(const QuantizedStatisticalModel& rhs);
+
+	// sets the column scales from the maximal absolute values and allocates the storage for the basis
+	void InitializeBasis(unsigned numberOfRows, const VectorType& columnMaxima);
+
+	// quantizes the given rows of the basis
+	void QuantizeRows(unsigned firstRow, const MatrixType& rows);
+
+	// dequantizes the given rows of the basis
+	void DequantizeRows(unsigned firstRow, unsigned numberOfRows, MatrixType& rows) const;
+
+	// computes the inverse of M = W^T W + sigma^2 I for the quantized basis
+	void UpdateCachedParameters();
+
+	// the kernels are implemented for both storage types. The scaled coefficients already include the column scales.
+	template <typename T> void DrawSampleKernel(const T* basis, const VectorType& scaledCoefficients, ScalarType* sample) const;
+	template <typename T> void ProjectionKernel(const T* basis, const VectorType& residual, VectorTypeDoublePrecision& projection) const;
+
+	// returns a pointer to the first entry of the basis, or 0 if the basis is empty (in which case the kernels do not read it)
+	template <typename T> static const T* GetBasisData(const std::vector<T>& basis) { return basis.empty() ? 0 : &basis[0]; }
+
+	static ScalarType Dequantize(signed char q) { return static_cast<ScalarType>(q); }
+	static ScalarType Dequantize(boost::uint16_t q) { return HalfToFloat(q); }
+
+	const Representer* m_representer;
+	QuantizationType m_quantizationType;
+
+	VectorType m_mean;
+	VectorType m_pcaVariance;
+	float m_noiseVariance;
+
+	// the basis in row major order. Only the vector corresponding to the quantization type is used.
+	std::vector<signed char> m_int8Basis;
+	std::vector<boost::uint16_t> m_fp16Basis;
+
+	// the factor by which the stored values of the j-th column are multiplied
+	VectorType m_columnScale;
+
+	MatrixTypeDoublePrecision m_MInverseMatrix;
+};
+
+
+} // namespace statismo
+
+#include "QuantizedStatisticalModel.txx"
+
+#endif /* __QUANTIZEDSTATISTICALMODEL_H_ */
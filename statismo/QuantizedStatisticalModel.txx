@@ -0,0 +1,449 @@
+/*
+ * This file is part of the statismo library.
+ *
+ * Author: Marcel Luethi (marcel.luethi@unibas.ch)
+ *
+ * Copyright (c) 2011 University of Basel
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ *
+ * Neither the name of the project's author nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+ * TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS addINTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#include "QuantizedStatisticalModel.h"
+#include "HDF5Utils.h"
+#include "Exceptions.h"
+#include "MixedPrecision.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace statismo {
+
+
+template <typename Representer>
+QuantizedStatisticalModel<Representer>::QuantizedStatisticalModel(const Representer* representer, QuantizationType quantizationType)
+: m_representer(representer), m_quantizationType(quantizationType), m_noiseVariance(0)
+{}
+
+
+template <typename Representer>
+QuantizedStatisticalModel<Representer>::~QuantizedStatisticalModel()
+{
+	if (m_representer != 0) {
+		// not all representers can implement a const correct version of delete.
+		const_cast<Representer*>(m_representer)->Delete();
+	}
+}
+
+
+template <typename Representer>
+QuantizedStatisticalModel<Representer>*
+QuantizedStatisticalModel<Representer>::Create(const StatisticalModelType* model, QuantizationType quantizationType) {
+
+	QuantizedStatisticalModel* newModel = new QuantizedStatisticalModel(model->GetRepresenter()->Clone(), quantizationType);
+	newModel->m_mean = model->GetMeanVector();
+	newModel->m_pcaVariance = model->GetPCAVarianceVector();
+	newModel->m_noiseVariance = model->GetNoiseVariance();
+
+	// the basis is quantized block by block, such that no full copy of the (possibly shared) basis is made
+	ConstMatrixViewType W = model->GetPCABasisMatrixView();
+	newModel->InitializeBasis(W.rows(), W.cwiseAbs().colwise().maxCoeff().transpose());
+	MatrixType block;
+	for (unsigned firstRow = 0; firstRow < W.rows(); firstRow += BLOCK_SIZE) {
+		block = W.middleRows(firstRow, std::min<unsigned>(BLOCK_SIZE, W.rows() - firstRow));
+		newModel->QuantizeRows(firstRow, block);
+	}
+	newModel->UpdateCachedParameters();
+	return newModel;
+}
+
+
+template <typename Representer>
+QuantizedStatisticalModel<Representer>*
+QuantizedStatisticalModel<Representer>::Load(const std::string& filename, QuantizationType quantizationType) {
+
+	using namespace H5;
+
+	H5File file;
+	try {
+		file = H5File(filename.c_str(), H5F_ACC_RDONLY);
+	}
+	catch (H5::Exception& e) {
+		 std::string msg(std::string("could not open HDF5 file \n") + e.getCDetailMsg());
+		 throw StatisticalModelException(msg.c_str());
+	}
+
+	QuantizedStatisticalModel* newModel = 0;
+	try {
+		Group modelRoot = file.openGroup("/");
+
+		Group representerGroup = modelRoot.openGroup("./representer");
+		std::string rep_name = HDF5Utils::readStringAttribute(representerGroup, "name");
+		if (rep_name != Representer::GetName() && Representer::GetName() != "TrivialVectorialRepresenter") {
+			throw StatisticalModelException("A different representer was used to create the file. Cannot load hdf5 file.");
+		}
+		newModel = new QuantizedStatisticalModel(Representer::Load(representerGroup), quantizationType);
+		representerGroup.close();
+
+		Group modelGroup = modelRoot.openGroup("./model");
+		HDF5Utils::readVector(modelGroup, "./mean", newModel->m_mean);
+		HDF5Utils::readVector(modelGroup, "./pcaVariance", newModel->m_pcaVariance);
+		newModel->m_noiseVariance = HDF5Utils::readFloat(modelGroup, "./noiseVariance");
+
+		// the basis is read twice, block by block. The first pass determines the scale of each column, the second one quantizes the values.
+		unsigned numberOfRows, numberOfColumns;
+		HDF5Utils::readMatrixDimensions(modelGroup, "./pcaBasis", numberOfRows, numberOfColumns);
+
+		MatrixType block;
+		VectorType columnMaxima = VectorType::Zero(numberOfColumns);
+		for (unsigned firstRow = 0; firstRow < numberOfRows; firstRow += BLOCK_SIZE) {
+			HDF5Utils::readMatrixRows(modelGroup, "./pcaBasis", firstRow, std::min<unsigned>(BLOCK_SIZE, numberOfRows - firstRow), block);
+			columnMaxima = columnMaxima.cwiseMax(block.cwiseAbs().colwise().maxCoeff().transpose());
+		}
+
+		newModel->InitializeBasis(numberOfRows, columnMaxima);
+		for (unsigned firstRow = 0; firstRow < numberOfRows; firstRow += BLOCK_SIZE) {
+			HDF5Utils::readMatrixRows(modelGroup, "./pcaBasis", firstRow, std::min<unsigned>(BLOCK_SIZE, numberOfRows - firstRow), block);
+			newModel->QuantizeRows(firstRow, block);
+		}
+
+		modelGroup.close();
+		modelRoot.close();
+	}
+	catch (H5::Exception& e) {
+		delete newModel;
+		std::string msg(std::string("an exeption occured while reading HDF5 file") +
+				 "The most likely cause is that the hdf5 file does not contain the required objects. \n" + e.getCDetailMsg());
+		throw StatisticalModelException(msg.c_str());
+	}
+	catch (StatisticalModelException& e) {
+		delete newModel;
+		throw;
+	}
+	file.close();
+
+	newModel->UpdateCachedParameters();
+	return newModel;
+}
+
+
+template <typename Representer>
+void
+QuantizedStatisticalModel<Representer>::InitializeBasis(unsigned numberOfRows, const VectorType& columnMaxima) {
+
+	if (numberOfRows != m_mean.rows()) {
+		throw StatisticalModelException("The PCA basis and the mean of the model do not match");
+	}
+
+	unsigned numberOfEntries = numberOfRows * columnMaxima.rows();
+	if (m_quantizationType == QUANTIZATION_INT8) {
+		// the values of a column are mapped to the integers -127, ..., 127
+		m_columnScale = columnMaxima / 127;
+		m_int8Basis.resize(numberOfEntries);
+	}
+	else {
+		// the values of a column are mapped to [-1, 1], where half precision numbers have their full relative precision
+		m_columnScale = columnMaxima;
+		m_fp16Basis.resize(numberOfEntries);
+	}
+}
+
+
+template <typename Representer>
+void
+QuantizedStatisticalModel<Representer>::QuantizeRows(unsigned firstRow, const MatrixType& rows) {
+
+	unsigned k = m_columnScale.rows();
+	VectorType inverseScale(k);
+	for (unsigned j = 0; j < k; j++) {
+		inverseScale[j] = m_columnScale[j] > 0 ? 1 / m_columnScale[j] : 0;
+	}
+
+	for (unsigned i = 0; i < rows.rows(); i++) {
+		unsigned offset = (firstRow + i) * k;
+		for (unsigned j = 0; j < k; j++) {
+			ScalarType v = rows(i, j) * inverseScale[j];
+			if (m_quantizationType == QUANTIZATION_INT8) {
+				ScalarType q = std::max<ScalarType>(-127, std::min<ScalarType>(127, std::floor(v + 0.5f)));
+				m_int8Basis[offset + j] = static_cast<signed char>(q);
+			}
+			else {
+				m_fp16Basis[offset + j] = FloatToHalf(v);
+			}
+		}
+	}
+}
+
+
+template <typename Representer>
+void
+QuantizedStatisticalModel<Representer>::DequantizeRows(unsigned firstRow, unsigned numberOfRows, MatrixType& rows) const {
+
+	unsigned k = m_columnScale.rows();
+	rows.resize(numberOfRows, k);
+	for (unsigned i = 0; i < numberOfRows; i++) {
+		unsigned offset = (firstRow + i) * k;
+		for (unsigned j = 0; j < k; j++) {
+			ScalarType q = (m_quantizationType == QUANTIZATION_INT8) ? Dequantize(m_int8Basis[offset + j]) : Dequantize(m_fp16Basis[offset + j]);
+			rows(i, j) = q * m_columnScale[j];
+		}
+	}
+}
+
+
+template <typename Representer>
+void
+QuantizedStatisticalModel<Representer>::UpdateCachedParameters() {
+
+	// M = W^T W + sigma^2 I is accumulated in double precision, block by block, such that the basis is never expanded completely
+	unsigned k = m_columnScale.rows();
+	unsigned p = m_mean.rows();
+
+	MatrixTypeDoublePrecision M = MatrixTypeDoublePrecision::Zero(k, k);
+	MatrixType block;
+	for (unsigned firstRow = 0; firstRow < p; firstRow += BLOCK_SIZE) {
+		DequantizeRows(firstRow, std::min<unsigned>(BLOCK_SIZE, p - firstRow), block);
+		M += MixedPrecision::TransposeTimesSelf(block);
+	}
+	M.diagonal().array() += m_noiseVariance;
+	m_MInverseMatrix = M.inverse();
+}
+
+
+template <typename Representer>
+VectorType
+QuantizedStatisticalModel<Representer>::GetQuantizationErrorBounds() const {
+	if (m_quantizationType == QUANTIZATION_INT8) {
+		return m_columnScale / 2;
+	}
+	else {
+		return m_columnScale * std::pow(2.0f, -11);
+	}
+}
+
+
+template <typename Representer>
+std::size_t
+QuantizedStatisticalModel<Representer>::GetBasisMemorySize() const {
+	return m_int8Basis.size() * sizeof(signed char) + m_fp16Basis.size() * sizeof(boost::uint16_t);
+}
+
+
+template <typename Representer>
+template <typename T>
+void
+QuantizedStatisticalModel<Representer>::DrawSampleKernel(const T* basis, const VectorType& scaledCoefficients, ScalarType* sample) const {
+
+	// A single sum over a row cannot be vectorized, as this would reorder the floating point additions. Each row is
+	// therefore summed into NUMBER_OF_ACCUMULATORS independent partial sums, whose lanes (including the dequantization)
+	// the compiler vectorizes. The remaining columns and the partial sums are added at the end of the row.
+	unsigned k = scaledCoefficients.rows();
+	unsigned kBlocked = k - k % NUMBER_OF_ACCUMULATORS;
+	const ScalarType* a = scaledCoefficients.data();
+	for (unsigned i = 0; i < m_mean.rows(); i++) {
+		const T* row = basis + i * k;
+		ScalarType partialSums[NUMBER_OF_ACCUMULATORS] = { 0 };
+		for (unsigned j = 0; j < kBlocked; j += NUMBER_OF_ACCUMULATORS) {
+			for (unsigned l = 0; l < NUMBER_OF_ACCUMULATORS; l++) {
+				partialSums[l] += Dequantize(row[j + l]) * a[j + l];
+			}
+		}
+		ScalarType value = 0;
+		for (unsigned j = kBlocked; j < k; j++) {
+			value += Dequantize(row[j]) * a[j];
+		}
+		for (unsigned l = 0; l < NUMBER_OF_ACCUMULATORS; l++) {
+			value += partialSums[l];
+		}
+		sample[i] += value;
+	}
+}
+
+
+template <typename Representer>
+template <typename T>
+void
+QuantizedStatisticalModel<Representer>::ProjectionKernel(const T* basis, const VectorType& residual, VectorTypeDoublePrecision& projection) const {
+
+	// the projection is a sum over all the p rows, and is therefore accumulated in double precision (c.f. MixedPrecision)
+	unsigned k = projection.rows();
+	double* a = projection.data();
+	for (unsigned i = 0; i < residual.rows(); i++) {
+		const T* row = basis + i * k;
+		double r = residual[i];
+		for (unsigned j = 0; j < k; j++) {
+			a[j] += Dequantize(row[j]) * r;
+		}
+	}
+}
+
+
+template <typename Representer>
+VectorType
+QuantizedStatisticalModel<Representer>::DrawSampleVector(const VectorType& coefficients) const {
+
+	if (coefficients.size() != GetNumberOfPrincipalComponents()) {
+		throw StatisticalModelException("Incorrect number of coefficients provided !");
+	}
+
+	// the column scales are applied to the k coefficients, rather than to the p x k entries of the basis
+	VectorType scaledCoefficients = coefficients.cwiseProduct(m_columnScale);
+
+	VectorType sample = m_mean;
+	if (m_quantizationType == QUANTIZATION_INT8) {
+		DrawSampleKernel(GetBasisData(m_int8Basis), scaledCoefficients, sample.data());
+	}
+	else {
+		DrawSampleKernel(GetBasisData(m_fp16Basis), scaledCoefficients, sample.data());
+	}
+	return sample;
+}
+
+
+template <typename Representer>
+typename QuantizedStatisticalModel<Representer>::DatasetPointerType
+QuantizedStatisticalModel<Representer>::DrawSample(const VectorType& coefficients) const {
+	return m_representer->SampleVectorToSample(DrawSampleVector(coefficients));
+}
+
+
+template <typename Representer>
+void
+QuantizedStatisticalModel<Representer>::DrawSampleAtPointInto(const VectorType& coefficients, unsigned ptId, ScalarType* value) const {
+
+	unsigned k = GetNumberOfPrincipalComponents();
+	if (coefficients.size() != k) {
+		throw StatisticalModelException("Incorrect number of coefficients provided !");
+	}
+
+	for (unsigned d = 0; d < Representer::GetDimensions(); d++) {
+		unsigned idx = Representer::MapPointIdToInternalIdx(ptId, d);
+		if (idx >= m_mean.rows()) {
+			throw StatisticalModelException("Invalid point id provided to DrawSampleAtPointInto");
+		}
+
+		ScalarType v = 0;
+		for (unsigned j = 0; j < k; j++) {
+			ScalarType q = (m_quantizationType == QUANTIZATION_INT8) ? Dequantize(m_int8Basis[idx * k + j]) : Dequantize(m_fp16Basis[idx * k + j]);
+			v += q * m_columnScale[j] * coefficients[j];
+		}
+		value[d] = m_mean[idx] + v;
+	}
+}
+
+
+template <typename Representer>
+VectorType
+QuantizedStatisticalModel<Representer>::ComputeCoefficientsForSampleVector(const VectorType& sample) const {
+
+	if (sample.rows() != m_mean.rows()) {
+		throw StatisticalModelException("The sample vector does not match the model dimensions!");
+	}
+
+	VectorType residual = sample - m_mean;
+	VectorTypeDoublePrecision projection = VectorTypeDoublePrecision::Zero(GetNumberOfPrincipalComponents());
+	if (m_quantizationType == QUANTIZATION_INT8) {
+		ProjectionKernel(GetBasisData(m_int8Basis), residual, projection);
+	}
+	else {
+		ProjectionKernel(GetBasisData(m_fp16Basis), residual, projection);
+	}
+
+	VectorTypeDoublePrecision WTx = projection.cwiseProduct(m_columnScale.cast<double>());
+	VectorTypeDoublePrecision coeffs = m_MInverseMatrix * WTx;
+	return coeffs.cast<ScalarType>();
+}
+
+
+template <typename Representer>
+VectorType
+QuantizedStatisticalModel<Representer>::ComputeCoefficientsForDataset(DatasetConstPointerType dataset) const {
+	DatasetPointerType sample = m_representer->DatasetToSample(dataset, 0);
+	VectorType coeffs = ComputeCoefficientsForSampleVector(m_representer->SampleToSampleVector(sample));
+	Representer::DeleteDataset(sample);
+	return coeffs;
+}
+
+
+template <typename Representer>
+boost::uint16_t
+QuantizedStatisticalModel<Representer>::FloatToHalf(float f) {
+
+	boost::uint32_t x;
+	std::memcpy(&x, &f, sizeof(x));
+
+	boost::uint16_t sign = static_cast<boost::uint16_t>((x >> 16) & 0x8000);
+	int exponent = static_cast<int>((x >> 23) & 0xff) - 127 + 15;
+	boost::uint32_t mantissa = x & 0x7fffff;
+
+	if (exponent <= 0) {
+		// the number is represented as a subnormal half precision number (or is zero)
+		if (exponent < -10) {
+			return sign;
+		}
+		mantissa |= 0x800000;
+		unsigned shift = 14 - exponent;
+		boost::uint32_t half = mantissa >> shift;
+		if ((mantissa >> (shift - 1)) & 1) {
+			half++;
+		}
+		return static_cast<boost::uint16_t>(sign | half);
+	}
+	if (exponent >= 31) {
+		// does not occur for the scaled values in [-1, 1]. We clamp to the largest half precision number
+		return static_cast<boost::uint16_t>(sign | 0x7bff);
+	}
+
+	boost::uint16_t half = static_cast<boost::uint16_t>(sign | (exponent << 10) | (mantissa >> 13));
+	if (mantissa & 0x1000) {
+		// round to nearest. A carry into the exponent yields the correct result, except beyond the largest number
+		half++;
+		if ((half & 0x7fff) == 0x7c00) {
+			half--;
+		}
+	}
+	return half;
+}
+
+
+template <typename Representer>
+float
+QuantizedStatisticalModel<Representer>::HalfToFloat(boost::uint16_t h) {
+
+	// The sign, exponent and mantissa bits are moved to their position in a float, and the exponent bias is corrected by
+	// a multiplication with 2^112. This handles normal and subnormal numbers without branches.
+	boost::uint32_t bits = (static_cast<boost::uint32_t>(h & 0x8000) << 16) | (static_cast<boost::uint32_t>(h & 0x7fff) << 13);
+	float f;
+	std::memcpy(&f, &bits, sizeof(f));
+	return f * 5.192296858534828e+33f;
+}
+
+
+} // namespace statismo
@@ -74,12 +74,8 @@ ReducedVarianceModelBuilder<Representer>::BuildNewModelFromModel(
 			  break;
 	  }
 
-	  StatisticalModelType* reducedModel = StatisticalModelType::Create(
-			  inputModel->GetRepresenter(),
-			  inputModel->GetMeanVector(),
-			  inputModel->GetOrthonormalPCABasisMatrix().leftCols(numComponentsToReachPrescribedVariance),
-			  inputModel->GetPCAVarianceVector().topRows(numComponentsToReachPrescribedVariance),
-			  inputModel->GetNoiseVariance());
+	  // the reduced model is a view of the leading components of the input model, which shares its mean and basis
+	  StatisticalModelType* reducedModel = StatisticalModelType::CreateTruncated(inputModel, numComponentsToReachPrescribedVariance);
 
 	// Write the parameters used to build the models into the builderInfo
 	typename ModelInfo::BuilderInfoList builderInfoList = inputModel->GetModelInfo().GetBuilderInfoList();
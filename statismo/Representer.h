@@ -88,6 +88,10 @@ public:
 	/// Returns the dimensionality of the dataset (for a mesh this is 3, for a scalar image
 	/// this would be 1)
 	static unsigned GetDimensions();
+
+	/// Optionally, the dimensionality can in addition be declared as a compile time constant. The per point computations
+	/// of the library then use fixed size vectors and matrices (see statismo::RepresenterTraits).
+	static const unsigned Dimensions;
 	///@}
 
 	/**
@@ -0,0 +1,110 @@
+/*
+ * This file is part of the statismo library.
+ *
+ * Author: Marcel Luethi (marcel.luethi@unibas.ch)
+ *
+ * Copyright (c) 2011 University of Basel
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ *
+ * Neither the name of the project's author nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+ * TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS addINTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#ifndef __REPRESENTERTRAITS_H_
+#define __REPRESENTERTRAITS_H_
+
+#include "CommonTypes.h"
+
+namespace statismo {
+
+namespace internal {
+
+// determines (at compile time) whether the representer declares a constant Dimensions
+template <typename Representer>
+class HasCompileTimeDimensions {
+	typedef char Yes;
+	typedef char No[2];
+
+	template <typename T> static Yes& Test(char (*)[T::Dimensions + 1]);
+	template <typename T> static No& Test(...);
+
+public:
+	enum { value = sizeof(Test<Representer>(0)) == sizeof(Yes) };
+};
+
+template <typename Representer, bool hasCompileTimeDimensions>
+struct CompileTimeDimensions {
+	enum { value = Eigen::Dynamic };
+};
+
+template <typename Representer>
+struct CompileTimeDimensions<Representer, true> {
+	enum { value = Representer::Dimensions };
+};
+
+} // namespace internal
+
+
+/**
+ * \brief Compile time information about a representer.
+ *
+ * Most representers know their dimension at compile time (e.g. 3 for a mesh, 1 for a scalar image).
+ * Such representers declare it as a constant
+ * \code
+ * static const unsigned Dimensions = 3;
+ * \endcode
+ * in addition to the method GetDimensions(). The per point computations of the library then use fixed size vectors and
+ * matrices, which the compiler keeps in registers, and which do not allocate any memory.
+ * For representers that do not declare the constant, Dimensions is Eigen::Dynamic and the dimension
+ * is obtained at runtime from Representer::GetDimensions().
+ */
+template <typename Representer>
+struct RepresenterTraits {
+
+	enum { Dimensions = internal::CompileTimeDimensions<Representer, internal::HasCompileTimeDimensions<Representer>::value>::value };
+
+	/// A vector holding the components of the value at a point
+	typedef Eigen::Matrix<ScalarType, Dimensions, 1> PointVectorType;
+
+	/// A matrix holding the covariance between the values at two points
+	typedef Eigen::Matrix<ScalarType, Dimensions, Dimensions, Eigen::RowMajor> PointMatrixType;
+
+	/// A vector holding the indices of the components of a point in the sample vector
+	typedef Eigen::Matrix<unsigned, Dimensions, 1> PointIndexVectorType;
+
+	/// Returns the dimension of the representer. For fixed size representers, this is a compile time constant.
+	static unsigned GetDimensions() {
+		return Dimensions == Eigen::Dynamic ? Representer::GetDimensions() : static_cast<unsigned>(Dimensions);
+	}
+};
+
+
+} // namespace statismo
+
+#endif /* __REPRESENTERTRAITS_H_ */
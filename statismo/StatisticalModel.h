@@ -43,6 +43,7 @@
 #include "DataManager.h"
 #include "CommonTypes.h"
 #include "ModelInfo.h"
+#include "RepresenterTraits.h"
 #include <vector>
 #include <limits>
 
@@ -114,6 +115,13 @@ public:
 	typedef std::pair<unsigned, RepresenterValueType> PointIdValuePairType;
 	typedef std::list<PointValuePairType> PointValueListType;
 	typedef std::list<PointIdValuePairType> PointIdValueListType;
+	typedef std::vector<unsigned> PointIdListType;
+	typedef std::pair<unsigned, unsigned> PointIdPairType;
+	typedef std::vector<PointIdPairType> PointIdPairListType;
+
+	typedef RepresenterTraits<Representer> RepresenterTraitsType;
+	typedef typename RepresenterTraitsType::PointVectorType PointVectorType;
+	typedef typename RepresenterTraitsType::PointMatrixType PointMatrixType;
 
 
 
@@ -150,6 +158,19 @@ public:
 		return new StatisticalModel(representer, m, orthonormalPCABasis, pcaVariance, noiseVariance);
 	}
 
+	/**
+	 * Factory method that creates a model from the leading principal components of the given model.
+	 *
+	 * The new model shares the mean and the PCA basis with the given model, it only holds its own variance vector.
+	 * Hence, no copy of the data is made and the creation time does not depend on the number of points.
+	 * The shared data is immutable and is freed once the last model that uses it is deleted. The model info
+	 * is not copied.
+	 *
+	 * \param model The model from which the components are taken
+	 * \param numberOfComponents The number of leading components to keep. It must not exceed the number of principal components of the model.
+	 */
+	static StatisticalModel* CreateTruncated(const StatisticalModel* model, unsigned numberOfComponents);
+
 
 	/**
 	 * Returns a new statistical model, which is loaded from the given HDF5 file
@@ -268,6 +289,16 @@ public:
 	 * */
 	DatasetPointerType DrawSample(const VectorType& coefficients, bool addNoise = false) const ;
 
+	/**
+	 * As DrawSample(const VectorType&, bool) with addNoise = true, but where the noise is taken from the given stream.
+	 * The other methods use the default stream (see Utils::GetDefaultRandomStream), which must not be used concurrently.
+	 *
+	 * \param coefficients The coefficients of the sample
+	 * \param noiseStream The random stream from which the noise is drawn
+	 * \sa RandomStream
+	 */
+	DatasetPointerType DrawSample(const VectorType& coefficients, RandomStream& noiseStream) const ;
+
 	/**
 	 * As StatisticalModel::DrawSample, but where the coefficients are chosen at random according to a standard normal distribution
 	 *
@@ -278,6 +309,38 @@ public:
 	 */
 	DatasetPointerType DrawSample(bool addNoise = false) const ;
 
+	/**
+	 * As StatisticalModel::DrawSample(bool), but where all the random numbers are taken from the given stream.
+	 * Parallel code should use one stream per thread, to obtain reproducible results.
+	 *
+	 * \param stream The random stream
+	 * \param addNoise If true, the Gaussian noise assumed in the model is added to the sample
+	 *
+	 * \return A new sample
+	 * \sa RandomStream
+	 */
+	DatasetPointerType DrawSample(RandomStream& stream, bool addNoise = false) const ;
+
+	/**
+	 * Draws n random samples from the model at once. All the coefficients are generated in one go and the samples
+	 * are computed with a single matrix-matrix product. As the samples are not converted to datasets, this is the
+	 * method of choice when many samples are needed (e.g. for Monte Carlo estimates).
+	 *
+	 * \param n The number of samples
+	 * \param seed The seed of the random stream (see RandomStream). The same seed always leads to the same samples.
+	 * \param addNoise If true, the Gaussian noise assumed in the model is added to the samples
+	 *
+	 * \return A \f$p \times n\f$ matrix, whose i-th column holds the i-th sample vector
+	 * \sa DrawSamples
+	 */
+	MatrixType DrawSampleVectors(unsigned n, unsigned seed, bool addNoise = false) const;
+
+	/**
+	 * As DrawSampleVectors, but where each sample is converted to a new dataset.
+	 * The caller is responsible for deleting the datasets.
+	 */
+	std::vector<DatasetPointerType> DrawSamples(unsigned n, unsigned seed, bool addNoise = false) const;
+
 
 
 	/**
@@ -333,6 +396,55 @@ public:
 	 */
 	RepresenterValueType DrawSampleAtPoint(const VectorType& coefficients, unsigned pointId, bool addNoise = false) const;
 
+	/**
+	 * As DrawSampleAtPoint with addNoise = true, but where the noise is taken from the given stream.
+	 */
+	RepresenterValueType DrawSampleAtPoint(const VectorType& coefficients, const PointType& point, RandomStream& noiseStream) const;
+
+	/**
+	 * As DrawSampleAtPoint with addNoise = true, but where the noise is taken from the given stream.
+	 */
+	RepresenterValueType DrawSampleAtPoint(const VectorType& coefficients, unsigned pointId, RandomStream& noiseStream) const;
+
+	/**
+	 * Same as DrawSampleAtPoint, but the value is written in its vectorial representation
+	 * (see Representer::PointSampleToPointSampleVector) to the given buffer.
+	 * In contrast to DrawSampleAtPoint, this method does not allocate any memory, which makes it
+	 * suitable for the inner loops of fitting algorithms.
+	 *
+	 * \param coefficients the coefficients of the sample
+	 * \param pointId the id of the point where the sample is evaluated
+	 * \param value Output parameter. A buffer with space for (at least) Representer::GetDimensions() values.
+	 * \param addNoise If true, the Gaussian noise assumed in the model is added to the sample
+	 */
+	void DrawSampleAtPointInto(const VectorType& coefficients, unsigned pointId, ScalarType* value, bool addNoise = false) const;
+
+	/**
+	 * As DrawSampleAtPointInto with addNoise = true, but where the noise is taken from the given stream.
+	 * Parallel code should use one stream per thread.
+	 */
+	void DrawSampleAtPointInto(const VectorType& coefficients, unsigned pointId, ScalarType* value, RandomStream& noiseStream) const;
+
+	/**
+	 * Returns the values of the sample defined by coefficients at all the given point ids.
+	 * This is much more efficient than calling DrawSampleAtPoint for each point, as the point ids are
+	 * mapped and validated only once, and the values are computed in a single pass over the
+	 * corresponding rows of the PCA basis.
+	 *
+	 * \param coefficients the coefficients of the sample
+	 * \param pointIds The ids of the points where the sample is evaluated
+	 * \param addNoise If true, the Gaussian noise assumed in the model is added to the sample
+	 *
+	 * \returns A vector of size pointIds.size() * Representer::GetDimensions(), where the d-th component
+	 * of the value at the i-th point is stored in the entry i * Representer::GetDimensions() + d
+	 */
+	VectorType DrawSampleAtPoints(const VectorType& coefficients, const PointIdListType& pointIds, bool addNoise = false) const;
+
+	/**
+	 * As DrawSampleAtPoints with addNoise = true, but where the noise is taken from the given stream.
+	 */
+	VectorType DrawSampleAtPoints(const VectorType& coefficients, const PointIdListType& pointIds, RandomStream& noiseStream) const;
+
 
 	/**
 	 * Computes the jacobian of the Statistical model at a given point
@@ -354,6 +466,29 @@ public:
 	 * @returns a d x d covariance matrix
 	 */
 	MatrixType GetCovarianceAtPoint(unsigned ptId1, unsigned ptId2) const;
+
+	/**
+	 * Same as GetCovarianceAtPoint, but the d x d covariance matrix is written in row major order to the given buffer.
+	 * For representers whose dimension is known at compile time (see RepresenterTraits), this method
+	 * does not allocate any memory.
+	 *
+	 * \param ptId1 The id of the first point
+	 * \param ptId2 The id of the second point
+	 * \param cov Output parameter. A buffer with space for (at least) d * d values.
+	 */
+	void GetCovarianceAtPointInto(unsigned ptId1, unsigned ptId2, ScalarType* cov) const;
+
+	/**
+	 * Returns the d x d covariance matrices for all the given pairs of point ids.
+	 * This is equivalent to calling GetCovarianceAtPoint for each pair, but the point ids are validated
+	 * only once and the rows of the PCA basis are accessed in place.
+	 *
+	 * @param pointIdPairs A list of pairs of point ids
+	 * @returns A (pointIdPairs.size() * d) x d matrix, where the rows i * d to (i+1) * d - 1 hold the
+	 * covariance matrix of the i-th pair.
+	 * \sa CovarianceOperator::GetPointCovariances for the covariance matrices at all the points of the model
+	 */
+	MatrixType GetCovarianceAtPoints(const PointIdPairListType& pointIdPairs) const;
 	///@}
 
 
@@ -367,17 +502,16 @@ public:
 	 * n points, in d dimensions, then this is a \f$nd \times nd\f$ matrix of
 	 * n \f$d \times d \f$ block matrices corresponding to the covariance at each point.
 	 * \warning This method is only useful when $n$ is small, since otherwise the matrix
-	 * becomes huge.
+	 * becomes huge. For large models, use a CovarianceOperator, which works directly with the low rank factors.
 	 */
 	MatrixType GetCovarianceMatrix() const;
 
 	/**
-	 * Returns the probability of observing the given dataset under this model.
-	 * If the coefficients \f$\alpha \in \mathbf{R}^n\f$ define the dataset, the probability is
-	 * \f$
-	 * (2 \pi)^{- \frac{n}{2}} \exp(||\alpha||)
-	 * \f$
+	 * Returns the probability density of observing the given dataset under this model.
+	 * This is the exponential of ComputeLogProbabilityOfDataset.
 	 *
+	 * \warning For large models the density is usually too small to be represented as a double.
+	 * Prefer ComputeLogProbabilityOfDataset in this case.
 	 *
 	 * \param datatset The dataset
 	 * \return The probability
@@ -385,7 +519,16 @@ public:
 	double ComputeProbabilityOfDataset(DatasetConstPointerType dataset) const ;
 
 	/**
-	 * Returns the log probability of observing a given dataset.
+	 * Returns the log probability density of observing a given dataset.
+	 * For a model with noise variance \f$\sigma^2 > 0\f$, this is the exact marginal log-likelihood of the PPCA model
+	 * \f[
+	 * \log p(S) = -\frac{1}{2} \left( p \log(2 \pi) + \log |C| + (S - \mu)^T C^{-1} (S - \mu) \right),
+	 * \f]
+	 * with \f$C = W W^T + \sigma^2 I\f$. Using the Woodbury identity and the matrix determinant lemma, it is evaluated
+	 * in \f$O(pk)\f$ without ever forming \f$C\f$.
+	 *
+	 * For a model without noise (i.e. a standard PCA model), the density is degenerate. In this case,
+	 * the log density \f$-\frac{1}{2}(k \log(2 \pi) + \|\alpha\|^2)\f$ of the coefficients \f$\alpha\f$ of the dataset is returned.
 	 *
 	 * \param dataset The dataset
 	 * \return The log probability
@@ -393,6 +536,17 @@ public:
 	 */
 	double ComputeLogProbabilityOfDataset(DatasetConstPointerType dataset) const ;
 
+	/**
+	 * Returns the log probability (see ComputeLogProbabilityOfDataset) for all the sample vectors that are given as the rows
+	 * of the sample matrix. All the samples are projected at once, using a single matrix-matrix product, which is much
+	 * faster than calling ComputeLogProbabilityOfDataset for each dataset (e.g. when a large population is scored).
+	 * The sample vectors are obtained from the datasets with Representer::SampleToSampleVector.
+	 *
+	 * \param sampleMatrix A \f$n \times p\f$ matrix, holding one sample vector per row
+	 * \returns A vector with the \f$n\f$ log probabilities
+	 */
+	VectorTypeDoublePrecision ComputeLogProbabilityOfSampleMatrix(const MatrixType& sampleMatrix) const;
+
 	/**
 	 *
 	 * Converts the given dataset to a sample of the model and compute the latent variable
@@ -441,6 +595,9 @@ public:
 	 *
 	 * \param pointValues A list with (Point,Value) pairs, a list of (PointId, Value) is provided.
 	 * \param pointValueNoiseVariance The variance of estimated (gaussian) noise at the known points
+	 *
+	 * Each call builds a temporary EvaluationPlan. If the coefficients need to be computed repeatedly for the same
+	 * points, create the plan once and use EvaluationPlan::ComputeCoefficientsForValues instead.
 	 */
 	 //RB: I had to modify the method name, to avoid prototype collisions when the PointType corresponds to unsigned (= type of the point id)
 	VectorType ComputeCoefficientsForPointIDValues(const PointIdValueListType&  pointValues, double pointValueNoiseVariance=0.0) const;
@@ -449,15 +606,34 @@ public:
 	 * Computes the coefficients of the latent variables in a robust way.
 	 * Instead of assuming Normally distributed noise on the data set points such as it is
 	 * implicitely assumed in the ComputeCoefficientsForDataset, A student-t distribution is assumed for the noise.
-	 * The solution is obtained using an EM algorithm.
+	 * The solution is obtained using an EM algorithm, which amounts to iteratively reweighted least squares:
+	 * In each iteration, every component j of the sample receives the weight
+	 * \f$\lambda_j = (\nu + 1) / (\nu \sigma^2 + r_j^2)\f$, where \f$r\f$ is the residual of the current solution,
+	 * and the coefficients are updated by solving the \f$k \times k\f$ system
+	 * \f$(W^T \Lambda W + I) \alpha = W^T \Lambda (S - \mu)\f$.
+	 * The iterations start from the coefficients given by ComputeCoefficientsForDataset.
 	 *
 	 * \param dataset The dataset
-	 * \param nIterations The number of iterations for the EM algorithm
+	 * \param nIterations The maximal number of iterations for the EM algorithm
 	 * \param nu The number of degrees of Freedom for the Student-t distribution defining the noise model
 	 * \param sigma2 The scale parameter of the t-distribution
+	 * \param tolerance The iterations stop as soon as the change of the coefficients is smaller than tolerance * (1 + \f$\|\alpha\|\f$)
 	 *
 	 */
-	VectorType RobustlyComputeCoefficientsForDataset(DatasetConstPointerType dataset, unsigned nIterations=100, unsigned nu=6, double sigma2=1) const;
+	VectorType RobustlyComputeCoefficientsForDataset(DatasetConstPointerType dataset, unsigned nIterations=100, unsigned nu=6, double sigma2=1, double tolerance=1e-5) const;
+
+	/**
+	 * Computes the coefficients in a robust way (see RobustlyComputeCoefficientsForDataset) for all the sample vectors
+	 * that are given as the rows of the sample matrix. The initial coefficients of all samples are computed at once,
+	 * and the working memory is shared between the samples, which makes this much faster than calling
+	 * RobustlyComputeCoefficientsForDataset for each dataset.
+	 * The sample vectors are obtained from the datasets with Representer::SampleToSampleVector.
+	 *
+	 * \param sampleMatrix A \f$n \times p\f$ matrix, holding one sample vector per row
+	 * \param nIterations, nu, sigma2, tolerance see RobustlyComputeCoefficientsForDataset
+	 * \returns A \f$k \times n\f$ matrix, whose i-th column holds the coefficients of the i-th sample
+	 */
+	MatrixType RobustlyComputeCoefficientsForSampleMatrix(const MatrixType& sampleMatrix, unsigned nIterations=100, unsigned nu=6, double sigma2=1, double tolerance=1e-5) const;
 	///@}
 
 	/**
@@ -491,22 +667,54 @@ public:
 	 * \f$n\f$ points, the returned matrix \f$W\f$ has dimensionality \f$W \in \mathbf{R}^{dp \times n} \f$, i.e.
 	 * the \f$d\f$ components are stacked into the matrix. The order of the components in the matrix is
 	 * undefined and depends on the representer.
-	  *
+	 *
+	 * The basis of a model that is created by CreateTruncated is shared with the original model. For such a model,
+	 * the leading columns of the shared basis are copied on the first call. Use GetPCABasisMatrixView to avoid the copy.
 	 */
 	const MatrixType& GetPCABasisMatrix() const;
 
+	/**
+	 * Returns a read only view of the PCA basis (see GetPCABasisMatrix), which is never copied, even if the basis
+	 * is shared with other models (see CreateTruncated).
+	 * The view is valid as long as the model exists. It can be assigned to a MatrixType to obtain a copy.
+	 */
+	ConstMatrixViewType GetPCABasisMatrixView() const;
+
 	/**
 	 * Returns the PCA Matrix, but with its principal axis normalized to unit length.
-	 * \warning This is more expensive than GetPCABasisMatrix as the matrix has to be computed
-	 * and a copy is returned
+	 *
+	 * The matrix is not stored. A read only expression is returned, which divides the columns of the PCA basis
+	 * by the standard deviations whenever a coefficient is accessed. It is valid as long as the model exists,
+	 * and can be assigned to a MatrixType to obtain a copy.
 	 */
-	MatrixType GetOrthonormalPCABasisMatrix() const;
+	ConstScaledMatrixViewType GetOrthonormalPCABasisMatrix() const;
 
 	/**
 	 * Returns an instance for the given coefficients as a vector.
 	 * \param addNoise If true, the Gaussian noise assumed in the model is added to the sample
 	 */
 	VectorType DrawSampleVector(const VectorType& coefficients, bool addNoise = false) const ;
+
+	/**
+	 * As DrawSampleVector with addNoise = true, but where the noise is taken from the given stream.
+	 */
+	VectorType DrawSampleVector(const VectorType& coefficients, RandomStream& noiseStream) const ;
+
+	/**
+	 * Same as DrawSampleVector, but the instance is written to the given buffer instead of a newly allocated vector.
+	 * No memory is allocated by this method, which makes it suitable for the inner loops of fitting algorithms.
+	 *
+	 * \param coefficients The coefficients of the instance
+	 * \param sample Output parameter. A buffer with space for (at least) GetMeanVector().rows() values.
+	 * \param addNoise If true, the Gaussian noise assumed in the model is added to the sample
+	 */
+	void DrawSampleVectorInto(const VectorType& coefficients, ScalarType* sample, bool addNoise = false) const;
+
+	/**
+	 * As DrawSampleVectorInto with addNoise = true, but where the noise is taken from the given stream.
+	 * Parallel code should use one stream per thread.
+	 */
+	void DrawSampleVectorInto(const VectorType& coefficients, ScalarType* sample, RandomStream& noiseStream) const;
 	///@}
 
 
@@ -522,6 +730,31 @@ public:
 	 */
 	VectorType ComputeCoefficientsForSampleVector(const VectorType& sample) const;
 
+	/**
+	 * Computes the coefficients for all the sample vectors that are given as the rows of the sample matrix.
+	 * The result is the same as calling ComputeCoefficientsForSampleVector for each row, but all the samples
+	 * are projected at once using a single matrix-matrix product.
+	 * This is for library internal use only.
+	 *
+	 * \param sampleMatrix A \f$n \times p\f$ matrix, holding one sample vector per row
+	 * \returns A \f$k \times n\f$ matrix, whose i-th column holds the coefficients of the i-th sample
+	 */
+	MatrixType ComputeCoefficientsForSampleMatrix(const MatrixType& sampleMatrix) const;
+
+	/**
+	 * Maps all the components of the given points to their index in the sample vector.
+	 * The index of the d-th component of the i-th point is stored at position i * Representer::GetDimensions() + d.
+	 * An exception is thrown if a point id is invalid.
+	 * This is for library internal use only.
+	 */
+	std::vector<unsigned> MapPointIdsToInternalIndices(const PointIdListType& pointIds) const;
+
+	/**
+	 * Computes the log probability of the given sample vector (see ComputeLogProbabilityOfDataset).
+	 * This is for library internal use only.
+	 */
+	double ComputeLogProbabilityOfSampleVector(const VectorType& sample) const;
+
 
 	/**
 	 * Return an instance of the representer
@@ -538,8 +771,18 @@ public:
 	///@}
 
 private:
-	// computes the M Matrix for the PPCA Method (see Bishop, PRML, Chapter 12)
-	void CheckAndUpdateCachedParameters() const;
+	// computes the M Matrix for the PPCA Method (see Bishop, PRML, Chapter 12).
+	// It is called whenever the model parameters are set (i.e. at construction or load time), such that
+	// all the const methods of the model are free of side effects and can be called concurrently.
+	void UpdateCachedParameters();
+
+	// computes M and its inverse from the Gram matrix W^T W, which has to be set before. This is done in O(k^3),
+	// independently of the number of points.
+	void UpdateCachedParametersFromGramMatrix();
+
+	// returns the indices of the components of the given point in the sample vector, and throws if the point id is invalid.
+	// For representers with a compile time dimension, the indices are held in a fixed size vector
+	typename RepresenterTraitsType::PointIndexVectorType GetPointIndices(unsigned ptId) const;
 
 
 
@@ -550,24 +793,36 @@ private:
 	StatisticalModel(const Representer* representer, const VectorType& m, const MatrixType& orthonormalPCABasis, const VectorType& pcaVariance, double noiseVariance);
 
 	/** Create an empty model. This is only used for the load method, which then sets all the parameters manually */
-	StatisticalModel(const Representer* representer) : m_representer(representer), m_noiseVariance(0), m_cachedValuesValid(0) {}
+	StatisticalModel(const Representer* representer) : m_representer(representer), m_noiseVariance(0), m_logDetCovariance(0) {}
 
 	// to prevent use
 	StatisticalModel(const StatisticalModel& rhs);
 	StatisticalModel& operator=(const StatisticalModel& rhs);
 
 	const Representer* m_representer;
-	VectorType m_mean;
-	MatrixType m_pcaBasisMatrix;
+
+	// the mean and the basis are immutable and shared with all the models that are created from this model by CreateTruncated.
+	// The basis can have more columns than the model has components, of which only the leading ones belong to the model.
+	// The number of components is given by the size of the variance vector.
+	shared_ptr<const VectorType> m_mean;
+	shared_ptr<const MatrixType> m_pcaBasisMatrix;
 	VectorType m_pcaVariance;
 	float m_noiseVariance;
 
+	// the Gram matrix W^T W. The Gram matrix of a truncated model is the leading block of this matrix
+	MatrixTypeDoublePrecision m_gramMatrix;
+
+	// the copy of the leading columns of a shared basis, which is only created if GetPCABasisMatrix is called for a truncated model
+	mutable shared_ptr<const MatrixType> m_truncatedPCABasisMatrix;
 
-	// caching
-	mutable bool m_cachedValuesValid;
+	// the inverse of the square root of the pcaVariance, with which the basis is scaled to obtain the orthonormal basis U = W D^{-1/2}
+	VectorType m_inversePCAStandardDeviations;
 
 	//the matrix M^{-1} in Bishops PRML book. This is roughly the Latent Covariance matrix (but not exactly)
-	mutable MatrixType m_MInverseMatrix;
+	MatrixTypeDoublePrecision m_MInverseMatrix;
+
+	// the log determinant of the covariance matrix W W^T + sigma^2 I
+	double m_logDetCovariance;
 
 	ModelInfo m_modelInfo;
 
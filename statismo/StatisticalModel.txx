@@ -40,7 +40,10 @@
 #include "StatisticalModel.h"
 #include "HDF5Utils.h"
 #include "Exceptions.h"
+#include "EvaluationPlan.h"
+#include "MixedPrecision.h"
 #include <fstream>
+#include <memory>
 #include <string>
 #include <iostream>
 #include <cmath>
@@ -50,17 +53,37 @@ namespace statismo {
 template <typename Representer>
 StatisticalModel<Representer>::StatisticalModel(const Representer* representer, const VectorType& m, const MatrixType& orthonormalPCABasis, const VectorType& pcaVariance, double noiseVariance)
 : m_representer(representer->Clone()),
-  m_mean(m),
+  m_mean(new VectorType(m)),
   m_pcaVariance(pcaVariance),
-  m_noiseVariance(noiseVariance),
-  m_cachedValuesValid(false)
+  m_noiseVariance(noiseVariance)
   {
 	VectorType D = pcaVariance.array().sqrt();
-	m_pcaBasisMatrix = orthonormalPCABasis * DiagMatrixType(D);
+	m_pcaBasisMatrix.reset(new MatrixType(orthonormalPCABasis * DiagMatrixType(D)));
+	UpdateCachedParameters();
 
   }
 
 
+template <typename Representer>
+StatisticalModel<Representer>*
+StatisticalModel<Representer>::CreateTruncated(const StatisticalModel* model, unsigned numberOfComponents) {
+
+	if (numberOfComponents > model->GetNumberOfPrincipalComponents()) {
+		throw StatisticalModelException("The number of components provided to CreateTruncated exceeds the number of principal components of the model");
+	}
+
+	// the leading columns of W = U D^{1/2} are the basis of the truncated model, hence the data is simply shared
+	StatisticalModel* newModel = new StatisticalModel(model->m_representer->Clone());
+	newModel->m_mean = model->m_mean;
+	newModel->m_pcaBasisMatrix = model->m_pcaBasisMatrix;
+	newModel->m_pcaVariance = model->m_pcaVariance.topRows(numberOfComponents);
+	newModel->m_noiseVariance = model->m_noiseVariance;
+	newModel->m_gramMatrix = model->m_gramMatrix.topLeftCorner(numberOfComponents, numberOfComponents);
+	newModel->UpdateCachedParametersFromGramMatrix();
+	return newModel;
+}
+
+
 template <typename Representer>
 StatisticalModel<Representer>::~StatisticalModel()
 {
@@ -126,10 +149,22 @@ template <typename Representer>
 typename StatisticalModel<Representer>::DatasetPointerType
 StatisticalModel<Representer>::DrawSample(bool addNoise) const {
 
+	return DrawSample(Utils::GetDefaultRandomStream(), addNoise);
+}
+
+
+template <typename Representer>
+typename StatisticalModel<Representer>::DatasetPointerType
+StatisticalModel<Representer>::DrawSample(RandomStream& stream, bool addNoise) const {
+
 	// we create random coefficients and draw a random sample from the model
-	VectorType coeffs = Utils::generateNormalVector(GetNumberOfPrincipalComponents());
+	VectorType coeffs = Utils::generateNormalVector(GetNumberOfPrincipalComponents(), stream);
 
-	return DrawSample(coeffs, addNoise);
+	VectorType sample = DrawSampleVector(coeffs, false);
+	if (addNoise) {
+		sample += Utils::generateNormalVector(sample.rows(), stream) * sqrt(m_noiseVariance);
+	}
+	return m_representer->SampleVectorToSample(sample);
 }
 
 
@@ -140,6 +175,49 @@ StatisticalModel<Representer>::DrawSample(const VectorType& coefficients, bool a
 }
 
 
+template <typename Representer>
+typename StatisticalModel<Representer>::DatasetPointerType
+StatisticalModel<Representer>::DrawSample(const VectorType& coefficients, RandomStream& noiseStream) const {
+	return m_representer->SampleVectorToSample(DrawSampleVector(coefficients, noiseStream));
+}
+
+
+template <typename Representer>
+MatrixType
+StatisticalModel<Representer>::DrawSampleVectors(unsigned n, unsigned seed, bool addNoise) const {
+
+	RandomStream stream(seed);
+
+	// the coefficients of each sample are stored in a row, such that the i-th sample does not depend on n
+	MatrixType coeffs = Utils::generateNormalMatrix(n, GetNumberOfPrincipalComponents(), stream);
+
+	MatrixType samples(m_mean->rows(), n);
+	samples.noalias() = GetPCABasisMatrixView() * coeffs.transpose();
+	samples.colwise() += *m_mean;
+
+	if (addNoise) {
+		samples += Utils::generateNormalMatrix(n, m_mean->rows(), stream).transpose() * sqrt(m_noiseVariance);
+	}
+	return samples;
+}
+
+
+template <typename Representer>
+std::vector<typename StatisticalModel<Representer>::DatasetPointerType>
+StatisticalModel<Representer>::DrawSamples(unsigned n, unsigned seed, bool addNoise) const {
+
+	MatrixType samples = DrawSampleVectors(n, seed, addNoise);
+
+	std::vector<DatasetPointerType> datasets;
+	datasets.reserve(n);
+	for (unsigned i = 0; i < n; i++) {
+		VectorType sample = samples.col(i);
+		datasets.push_back(m_representer->SampleVectorToSample(sample));
+	}
+	return datasets;
+}
+
+
 template <typename Representer>
 typename StatisticalModel<Representer>::DatasetPointerType
 StatisticalModel<Representer>::DrawPCABasisSample(const unsigned pcaComponent) const {
@@ -148,7 +226,7 @@ StatisticalModel<Representer>::DrawPCABasisSample(const unsigned pcaComponent) c
 	}
 
 
-	return m_representer->SampleVectorToSample( m_pcaBasisMatrix.col(pcaComponent));
+	return m_representer->SampleVectorToSample( GetPCABasisMatrixView().col(pcaComponent));
 }
 
 
@@ -157,20 +235,56 @@ template <typename Representer>
 VectorType
 StatisticalModel<Representer>::DrawSampleVector(const VectorType& coefficients, bool addNoise) const {
 
+	VectorType sample(m_mean->rows());
+	DrawSampleVectorInto(coefficients, sample.data(), addNoise);
+	return sample;
+}
+
+
+template <typename Representer>
+VectorType
+StatisticalModel<Representer>::DrawSampleVector(const VectorType& coefficients, RandomStream& noiseStream) const {
+
+	VectorType sample(m_mean->rows());
+	DrawSampleVectorInto(coefficients, sample.data(), noiseStream);
+	return sample;
+}
+
+
+template <typename Representer>
+void
+StatisticalModel<Representer>::DrawSampleVectorInto(const VectorType& coefficients, ScalarType* sample, bool addNoise) const {
+
+	if (addNoise) {
+		DrawSampleVectorInto(coefficients, sample, Utils::GetDefaultRandomStream());
+		return;
+	}
+
 	if (coefficients.size() != this->GetNumberOfPrincipalComponents()) {
 		throw StatisticalModelException("Incorrect number of coefficients provided !");
 	}
 
-	unsigned vectorSize = this->m_mean.size();
+	unsigned vectorSize = this->m_mean->size();
 	assert (vectorSize != 0);
 
-	VectorType epsilon = VectorType::Zero(vectorSize);
-	if (addNoise) {
-		epsilon = Utils::generateNormalVector(vectorSize) * sqrt(m_noiseVariance);
-	}
+	// the product is evaluated directly into the output buffer, such that no temporaries are created
+	Eigen::Map<VectorType> s(sample, vectorSize);
+	s.noalias() = GetPCABasisMatrixView() * coefficients;
+	s += *m_mean;
+}
+
+
+template <typename Representer>
+void
+StatisticalModel<Representer>::DrawSampleVectorInto(const VectorType& coefficients, ScalarType* sample, RandomStream& noiseStream) const {
 
+	DrawSampleVectorInto(coefficients, sample, false);
 
-	return m_mean+ m_pcaBasisMatrix * coefficients + epsilon;
+	unsigned vectorSize = this->m_mean->size();
+	ScalarType noiseSdev = std::sqrt(m_noiseVariance);
+	for (unsigned i = 0; i < vectorSize; i++) {
+		sample[i] += Utils::generateNormalScalar(noiseStream) * noiseSdev;
+	}
 }
 
 
@@ -184,34 +298,149 @@ StatisticalModel<Representer>::DrawSampleAtPoint(const VectorType& coefficients,
 
 }
 
+template <typename Representer>
+typename StatisticalModel<Representer>::RepresenterValueType
+StatisticalModel<Representer>::DrawSampleAtPoint(const VectorType& coefficients, const PointType& point, RandomStream& noiseStream) const {
+
+	unsigned ptId = this->m_representer->GetPointIdForPoint(point);
+
+	return DrawSampleAtPoint(coefficients, ptId, noiseStream);
+}
+
 template <typename Representer>
 typename StatisticalModel<Representer>::RepresenterValueType
 StatisticalModel<Representer>::DrawSampleAtPoint(const VectorType& coefficients, const unsigned ptId, bool addNoise) const {
 
-	unsigned dim = Representer::GetDimensions();
+	VectorType v(RepresenterTraitsType::GetDimensions());
+	DrawSampleAtPointInto(coefficients, ptId, v.data(), addNoise);
+
+	return this->m_representer->PointSampleVectorToPointSample(v);
+}
+
+template <typename Representer>
+typename StatisticalModel<Representer>::RepresenterValueType
+StatisticalModel<Representer>::DrawSampleAtPoint(const VectorType& coefficients, const unsigned ptId, RandomStream& noiseStream) const {
+
+	VectorType v(RepresenterTraitsType::GetDimensions());
+	DrawSampleAtPointInto(coefficients, ptId, v.data(), noiseStream);
+
+	return this->m_representer->PointSampleVectorToPointSample(v);
+}
+
+template <typename Representer>
+void
+StatisticalModel<Representer>::DrawSampleAtPointInto(const VectorType& coefficients, const unsigned ptId, ScalarType* value, bool addNoise) const {
 
-	VectorType v(dim);
-	VectorType epsilon = VectorType::Zero(dim);
 	if (addNoise) {
-		epsilon = Utils::generateNormalVector(dim) * sqrt(m_noiseVariance);
+		DrawSampleAtPointInto(coefficients, ptId, value, Utils::GetDefaultRandomStream());
+		return;
+	}
+
+	typedef typename RepresenterTraitsType::PointIndexVectorType PointIndexVectorType;
+	const PointIndexVectorType indices = GetPointIndices(ptId);
+
+	Eigen::Map<PointVectorType> v(value, indices.rows());
+	for (unsigned d = 0; d < indices.rows(); d++) {
+		v[d] = (*m_mean)[indices[d]] + GetPCABasisMatrixView().row(indices[d]).dot(coefficients);
 	}
+}
+
+template <typename Representer>
+void
+StatisticalModel<Representer>::DrawSampleAtPointInto(const VectorType& coefficients, const unsigned ptId, ScalarType* value, RandomStream& noiseStream) const {
+
+	DrawSampleAtPointInto(coefficients, ptId, value, false);
+
+	ScalarType noiseSdev = std::sqrt(m_noiseVariance);
+	for (unsigned d = 0; d < RepresenterTraitsType::GetDimensions(); d++) {
+		value[d] += Utils::generateNormalScalar(noiseStream) * noiseSdev;
+	}
+}
+
+
+template <typename Representer>
+typename StatisticalModel<Representer>::RepresenterTraitsType::PointIndexVectorType
+StatisticalModel<Representer>::GetPointIndices(unsigned ptId) const {
+
+	const unsigned dim = RepresenterTraitsType::GetDimensions();
+
+	typename RepresenterTraitsType::PointIndexVectorType indices;
+	indices.resize(dim);
 	for (unsigned d = 0; d < dim; d++) {
-		unsigned idx =Representer::MapPointIdToInternalIdx(ptId, d);
+		indices[d] = Representer::MapPointIdToInternalIdx(ptId, d);
 
-		if (idx >= m_mean.rows()) {
+		if (indices[d] >= m_mean->rows()) {
 			std::ostringstream os;
-			os << "Invalid idx computed in DrawSampleAtPoint. ";
-			os << " The most likely cause of this error is that you provided an invalid point id (" << ptId <<")";
+			os << "Invalid idx computed for point id " << ptId << ". ";
+			os << " The most likely cause of this error is that you provided an invalid point id.";
 			throw StatisticalModelException(os.str().c_str());
 		}
+	}
+	return indices;
+}
+
 
-		v[d] = m_mean[idx] + m_pcaBasisMatrix.row(idx).dot(coefficients) + epsilon[d];
+
+template <typename Representer>
+VectorType
+StatisticalModel<Representer>::DrawSampleAtPoints(const VectorType& coefficients, const PointIdListType& pointIds, bool addNoise) const {
+
+	if (addNoise) {
+		return DrawSampleAtPoints(coefficients, pointIds, Utils::GetDefaultRandomStream());
 	}
 
-	return this->m_representer->PointSampleVectorToPointSample(v);
+	if (coefficients.size() != this->GetNumberOfPrincipalComponents()) {
+		throw StatisticalModelException("Incorrect number of coefficients provided !");
+	}
+
+	std::vector<unsigned> indices = MapPointIdsToInternalIndices(pointIds);
+
+	// this is a GEMV with the rows of the basis that correspond to the points. The rows are
+	// used in place, as gathering them into a submatrix would cost as much as the product itself.
+	VectorType values(indices.size());
+	for (unsigned i = 0; i < indices.size(); i++) {
+		values[i] = (*m_mean)[indices[i]] + GetPCABasisMatrixView().row(indices[i]).dot(coefficients);
+	}
+	return values;
 }
 
 
+template <typename Representer>
+VectorType
+StatisticalModel<Representer>::DrawSampleAtPoints(const VectorType& coefficients, const PointIdListType& pointIds, RandomStream& noiseStream) const {
+
+	VectorType values = DrawSampleAtPoints(coefficients, pointIds, false);
+
+	ScalarType noiseSdev = std::sqrt(m_noiseVariance);
+	for (unsigned i = 0; i < values.rows(); i++) {
+		values[i] += Utils::generateNormalScalar(noiseStream) * noiseSdev;
+	}
+	return values;
+}
+
+
+template <typename Representer>
+std::vector<unsigned>
+StatisticalModel<Representer>::MapPointIdsToInternalIndices(const PointIdListType& pointIds) const {
+
+	unsigned dim = Representer::GetDimensions();
+
+	std::vector<unsigned> indices(pointIds.size() * dim);
+	for (unsigned i = 0; i < pointIds.size(); i++) {
+		for (unsigned d = 0; d < dim; d++) {
+			unsigned idx = Representer::MapPointIdToInternalIdx(pointIds[i], d);
+			if (idx >= m_mean->rows()) {
+				std::ostringstream os;
+				os << "Invalid idx computed in MapPointIdsToInternalIndices. ";
+				os << " The most likely cause of this error is that you provided an invalid point id (" << pointIds[i] <<")";
+				throw StatisticalModelException(os.str().c_str());
+			}
+			indices[i * dim + d] = idx;
+		}
+	}
+	return indices;
+}
+
 
 template <typename Representer>
 MatrixType
@@ -227,28 +456,50 @@ template <typename Representer>
 MatrixType
 StatisticalModel<Representer>::GetCovarianceAtPoint(unsigned ptId1, unsigned ptId2) const
 {
-	unsigned dim = Representer::GetDimensions();
-	MatrixType cov(dim, dim);
-
-	for (unsigned i = 0; i < dim; i++) {
-		unsigned idxi = Representer::MapPointIdToInternalIdx(ptId1, i);
-		VectorType vi = m_pcaBasisMatrix.row(idxi);
-		for (unsigned j = 0; j < dim; j++) {
-			unsigned idxj = Representer::MapPointIdToInternalIdx(ptId2, j);
-			VectorType vj = m_pcaBasisMatrix.row(idxj);
-			cov(i,j) = vi.dot(vj);
-			if (i == j) cov(i,j) += m_noiseVariance;
-		}
+	PointIdPairListType pointIdPairs(1, PointIdPairType(ptId1, ptId2));
+	return GetCovarianceAtPoints(pointIdPairs);
+}
+
+template <typename Representer>
+MatrixType
+StatisticalModel<Representer>::GetCovarianceAtPoints(const PointIdPairListType& pointIdPairs) const
+{
+	const unsigned dim = RepresenterTraitsType::GetDimensions();
+
+	// as the matrix is stored in row major order, the covariance matrix of each pair occupies a contiguous block
+	MatrixType cov(pointIdPairs.size() * dim, dim);
+	for (unsigned p = 0; p < pointIdPairs.size(); p++) {
+		GetCovarianceAtPointInto(pointIdPairs[p].first, pointIdPairs[p].second, cov.data() + p * dim * dim);
 	}
 	return cov;
 }
 
+template <typename Representer>
+void
+StatisticalModel<Representer>::GetCovarianceAtPointInto(unsigned ptId1, unsigned ptId2, ScalarType* covData) const
+{
+	typedef typename RepresenterTraitsType::PointIndexVectorType PointIndexVectorType;
+	const PointIndexVectorType indices1 = GetPointIndices(ptId1);
+	const PointIndexVectorType indices2 = GetPointIndices(ptId2);
+
+	ConstMatrixViewType W = GetPCABasisMatrixView();
+	Eigen::Map<PointMatrixType> cov(covData, indices1.rows(), indices2.rows());
+	for (unsigned i = 0; i < indices1.rows(); i++) {
+		for (unsigned j = 0; j < indices2.rows(); j++) {
+			cov(i, j) = W.row(indices1[i]).dot(W.row(indices2[j]));
+			// the noise is independent for each entry of the sample vector (c.f. GetCovarianceMatrix)
+			if (indices1[i] == indices2[j]) cov(i, j) += m_noiseVariance;
+		}
+	}
+}
+
 template <typename Representer>
 MatrixType
 StatisticalModel<Representer>::GetCovarianceMatrix() const
 {
-	MatrixType M = m_pcaBasisMatrix * m_pcaBasisMatrix.transpose();
-	M.diagonal() += m_noiseVariance * VectorType::Ones(m_pcaBasisMatrix.rows());
+	ConstMatrixViewType W = GetPCABasisMatrixView();
+	MatrixType M = W * W.transpose();
+	M.diagonal() += m_noiseVariance * VectorType::Ones(W.rows());
 	return M;
 }
 
@@ -272,11 +523,24 @@ template <typename Representer>
 VectorType
 StatisticalModel<Representer>::ComputeCoefficientsForSampleVector(const VectorType& sample) const {
 
-	CheckAndUpdateCachedParameters();
+	// the projection W^T (sample - mean) is accumulated in double precision directly from the stored basis
+	VectorTypeDoublePrecision WTx = MixedPrecision::TransposeTimes(GetPCABasisMatrixView(), sample - *m_mean);
+	VectorType coeffs = (m_MInverseMatrix * WTx).cast<ScalarType>();
+	return coeffs;
+}
+
+template <typename Representer>
+MatrixType
+StatisticalModel<Representer>::ComputeCoefficientsForSampleMatrix(const MatrixType& sampleMatrix) const {
 
-	const MatrixType& WT = m_pcaBasisMatrix.transpose();
+	if (sampleMatrix.cols() != m_mean->rows()) {
+		throw StatisticalModelException("The sample vectors provided to ComputeCoefficientsForSampleMatrix do not match the model dimensions!");
+	}
 
-	VectorType coeffs = m_MInverseMatrix * (WT * (sample - m_mean));
+	// we center the samples first and then project all of them with one matrix-matrix product
+	MatrixType X0 = sampleMatrix.rowwise() - m_mean->transpose();
+	MatrixTypeDoublePrecision WTX = MixedPrecision::TransposeTimesTransposed(GetPCABasisMatrixView(), X0);
+	MatrixType coeffs = (m_MInverseMatrix * WTX).cast<ScalarType>();
 	return coeffs;
 }
 
@@ -302,30 +566,24 @@ StatisticalModel<Representer>::ComputeCoefficientsForPointIDValues(const PointId
 
 	unsigned dim = Representer::GetDimensions();
 
-	double noiseVariance = std::max(pointValueNoiseVariance, (double) m_noiseVariance);
-
-	// build the part matrices with , considering only the points that are fixed
-	MatrixType PCABasisPart(pointIdValueList.size()* dim, this->GetNumberOfPrincipalComponents());
-	VectorType muPart(pointIdValueList.size() * dim);
+	PointIdListType pointIds(pointIdValueList.size());
 	VectorType sample(pointIdValueList.size() * dim);
 
 	unsigned i = 0;
 	for (typename PointIdValueListType::const_iterator it = pointIdValueList.begin(); it != pointIdValueList.end(); ++it) {
 		VectorType val = this->m_representer->PointSampleToPointSampleVector(it->second);
-		unsigned pt_id = it->first;
+		pointIds[i] = it->first;
 		for (unsigned d = 0; d < dim; d++) {
-			PCABasisPart.row(i * dim + d) = this->GetPCABasisMatrix().row(Representer::MapPointIdToInternalIdx(pt_id, d));
-			muPart[i * dim + d] = this->GetMeanVector()[Representer::MapPointIdToInternalIdx(pt_id, d)];
 			sample[i * dim + d] = val[d];
 		}
 		i++;
 	}
 
-	MatrixType M = PCABasisPart.transpose() * PCABasisPart;
-	M.diagonal() += noiseVariance * VectorType::Ones(PCABasisPart.cols());
-	VectorType coeffs = M.inverse() * PCABasisPart.transpose() * (sample - muPart);
-
-	return coeffs;
+	// the evaluation plan gathers the part of the model that belongs to the points and solves the system
+	// M alpha = B^T (sample - mu), with M = B^T B + sigma^2 I, using a cholesky factorization in double precision.
+	typedef EvaluationPlan<Representer> EvaluationPlanType;
+	std::auto_ptr<EvaluationPlanType> plan(EvaluationPlanType::Create(this, pointIds, pointValueNoiseVariance));
+	return plan->ComputeCoefficientsForValues(sample);
 }
 
 
@@ -334,81 +592,118 @@ StatisticalModel<Representer>::ComputeCoefficientsForPointIDValues(const PointId
 template <typename Representer>
 double
 StatisticalModel<Representer>::ComputeLogProbabilityOfDataset(DatasetConstPointerType ds) const {
-	VectorType alpha = ComputeCoefficientsForDataset(ds);
-	return log(pow(2 * PI, -0.5 * this->GetNumberOfPrincipalComponents())) - alpha.squaredNorm();
+	DatasetPointerType sample = m_representer->DatasetToSample(ds, 0);
+	double logProb = ComputeLogProbabilityOfSampleVector(m_representer->SampleToSampleVector(sample));
+	Representer::DeleteDataset(sample);
+	return logProb;
 }
 
 template <typename Representer>
 double
 StatisticalModel<Representer>::ComputeProbabilityOfDataset(DatasetConstPointerType ds) const {
-	VectorType alpha = ComputeCoefficientsForDataset(ds);
-	return pow(2 * PI, - 0.5 * this->GetNumberOfPrincipalComponents()) * exp(- alpha.squaredNorm());
+	return exp(ComputeLogProbabilityOfDataset(ds));
 }
 
-
 template <typename Representer>
-VectorType
-StatisticalModel<Representer>::RobustlyComputeCoefficientsForDataset(DatasetConstPointerType ds, unsigned nIterations, unsigned nu, double sigma2) const {
-	throw NotImplementedException("StatisticalModel", "RobustlyComputeCoefficientsForDataset");
-	/*
-	unsigned dim = Representer::GetDimensions();
-
-	// we use double to improve the stability
-	MatrixType U = Utils::toDouble(this->m_pcaBasisMatrix);
-	VectorType yfloat;
-	m_representer->DatasetToSample(ds,&yfloat);
-
-	MatrixTypeDoublePrecision y = Eigen::Map::toDouble(yfloat);
-	VectorTypeDoublePrecision mu = Utils::toDouble(this->m_mean);
-
+double
+StatisticalModel<Representer>::ComputeLogProbabilityOfSampleVector(const VectorType& sample) const {
+	MatrixType sampleMatrix = sample.transpose();
+	return ComputeLogProbabilityOfSampleMatrix(sampleMatrix)(0);
+}
 
-	const MatrixTypeDoublePrecision& UT = U.transpose();
+template <typename Representer>
+VectorTypeDoublePrecision
+StatisticalModel<Representer>::ComputeLogProbabilityOfSampleMatrix(const MatrixType& sampleMatrix) const {
 
-	unsigned nPCA = GetNumberOfPrincipalComponents();
+	if (sampleMatrix.cols() != m_mean->rows()) {
+		throw StatisticalModelException("The sample vectors provided to ComputeLogProbabilityOfSampleMatrix do not match the model dimensions!");
+	}
 
-	typedef typename Representer::DatasetTraitsType DatasetTraitsType;
+	unsigned k = GetNumberOfPrincipalComponents();
 
+	if (m_noiseVariance == 0) {
+		// without noise the density is degenerate. We use the density of the latent variables instead.
+		MatrixType alpha = ComputeCoefficientsForSampleMatrix(sampleMatrix);
+		VectorTypeDoublePrecision logProb = -0.5 * alpha.cast<double>().colwise().squaredNorm().transpose();
+		logProb.array() -= 0.5 * k * log(2 * PI);
+		return logProb;
+	}
 
-	Eigen::DiagonalWrapper<VectorTypeDoublePrecision> Vinv(VectorTypeDoublePrecision::Zero(y.size());
-	Eigen::DiagonalWrapper<VectorTypeDoublePrecision> VinvSqrt(VectorTypeDoublePrecision::Zero(y.size()));
+	// Woodbury identity: C^{-1} = 1/sigma^2 (I - W M^{-1} W^T). With r = S - mu and y = W^T r, the
+	// Mahalanobis distance becomes (r^T r - y^T M^{-1} y) / sigma^2, which only involves the k x k matrix M.
+	MatrixType X0 = sampleMatrix.rowwise() - m_mean->transpose();
+	MatrixTypeDoublePrecision Y = MixedPrecision::TransposeTimesTransposed(GetPCABasisMatrixView(), X0);
+	MatrixTypeDoublePrecision MInvY = m_MInverseMatrix * Y;
 
-	y -= mu;
-	VectorTypeDoublePrecision f = VectorTypeDoublePrecistion::Zero(y.size());
+	VectorTypeDoublePrecision squaredNorms(X0.rows());
+	for (unsigned i = 0; i < X0.rows(); i++) {
+		squaredNorms(i) = X0.row(i).cast<double>().squaredNorm();
+	}
+	VectorTypeDoublePrecision mahalanobis = (squaredNorms - Y.cwiseProduct(MInvY).colwise().sum().transpose()) / m_noiseVariance;
 
-	Eigen::DiagonalWrapper<VectorTypeDoublePrecision> D(Utils::toDouble(m_pcaVariance.topLeftCorner(nPCA)));
-	Eigen::DiagonalWrapper<VectorTypeDoublePrecision> Dinv = D.inverse();
-	Eigen::DiagonalWrapper<VectorTypeDoublePrecision>  D2 = D * D;
-	Eigen::DiagonalWrapper<VectorTypeDoublePrecision>  D2inv = D2.inverse();
+	VectorTypeDoublePrecision logProb = -0.5 * mahalanobis;
+	logProb.array() -= 0.5 * (m_mean->rows() * log(2 * PI) + m_logDetCovariance);
+	return logProb;
+}
 
-	for (unsigned i = 0; i < nIterations; i++) {
 
-		// E step
-		for (unsigned j = 0; j < Vinv.size(); j++) {
-			// student-t case
-			Vinv(j) = (nu + 1.0) / (nu * sigma2 + pow(y(j) -  f(j), 2));
+template <typename Representer>
+VectorType
+StatisticalModel<Representer>::RobustlyComputeCoefficientsForDataset(DatasetConstPointerType ds, unsigned nIterations, unsigned nu, double sigma2, double tolerance) const {
+	DatasetPointerType sample = m_representer->DatasetToSample(ds, 0);
+	MatrixType sampleMatrix = m_representer->SampleToSampleVector(sample).transpose();
+	Representer::DeleteDataset(sample);
+	return RobustlyComputeCoefficientsForSampleMatrix(sampleMatrix, nIterations, nu, sigma2, tolerance).col(0);
+}
 
-			// for later use
-			VinvSqrt(j) = sqrt(Vinv(j));
+template <typename Representer>
+MatrixType
+StatisticalModel<Representer>::RobustlyComputeCoefficientsForSampleMatrix(const MatrixType& sampleMatrix, unsigned nIterations, unsigned nu, double sigma2, double tolerance) const {
+
+	// the starting point are the coefficients obtained under the gaussian noise model. This also checks the dimensions
+	MatrixType coeffs = ComputeCoefficientsForSampleMatrix(sampleMatrix);
+
+	unsigned k = GetNumberOfPrincipalComponents();
+	unsigned p = m_mean->rows();
+
+	ConstMatrixViewType W = GetPCABasisMatrixView();
+
+	// the working memory is allocated only once for all the samples
+	VectorType y(p);
+	VectorType weights(p);
+	VectorType weightedY(p);
+	MatrixTypeDoublePrecision A(k, k);
+	VectorTypeDoublePrecision b(k);
+
+	for (unsigned i = 0; i < sampleMatrix.rows(); i++) {
+		y = sampleMatrix.row(i).transpose() - *m_mean;
+		VectorTypeDoublePrecision alpha = coeffs.col(i).cast<double>();
+
+		for (unsigned iter = 0; iter < nIterations; iter++) {
+			// E step: the weights are the expected precisions of the student-t noise, given the current residual
+			weights.noalias() = W * alpha.cast<ScalarType>();
+			for (unsigned j = 0; j < p; j++) {
+				double r = y(j) - weights(j);
+				weights(j) = (nu + 1.0) / (nu * sigma2 + r * r);
+			}
+
+			// M step: solve the weighted least squares problem (W^T Lambda W + I) alpha = W^T Lambda y.
+			// Only the k x k system is ever formed, and it is accumulated in double precision.
+			weightedY = weights.cwiseProduct(y);
+			A = MixedPrecision::TransposeTimesSelf(W, weights);
+			A.diagonal().array() += 1;
+			b = MixedPrecision::TransposeTimes(W, weightedY);
+
+			VectorTypeDoublePrecision alphaNew = A.llt().solve(b);
+			double change = (alphaNew - alpha).norm();
+			alpha = alphaNew;
+			if (change <= tolerance * (1 + alpha.norm())) {
+				break;
+			}
 		}
-
-		// M step
-		const MatrixTypeDoublePrecision W = VinvSqrt * U * D;
-		const MatrixTypeDoublePrecision WT = W.transpose();
-
-		const VectorTypeDoublePrecision outer_term = (Vinv * y);
-		const MatrixTypeDoublePrecision IWTWInv = vnl_matrix_inverse<double>(vnl_diag_matrix<double>(nPCA, 1) + WT * W);
-		const VectorTypeDoublePrecision fst_term = (U * (D2 * (UT * outer_term)));
-		const VectorTypeDoublePrecision snd_term = (U * (D2 * (UT * (Vinv * (U * (D2 * (UT * outer_term)))))));
-		const VectorTypeDoublePrecision trd_term = (U * (D2 * (UT * (VinvSqrt * (W * (IWTWInv * (WT * (VinvSqrt * (U * (D2 * (UT * outer_term)))))))))));
-		f = fst_term - snd_term + trd_term;
+		coeffs.col(i) = alpha.cast<ScalarType>();
 	}
-
-	// the latent variable f is now a robust approximation for the data set. We return its coefficients.
-	DatasetConstPointerType newds = m_representer->sampleToDataset(f);
-	VectorType coeffs = GetCoefficientsForData(newds);
-	Representer::DeleteDataset(newds);
 	return coeffs;
-	*/
 }
 
 
@@ -424,7 +719,7 @@ StatisticalModel<Representer>::GetNoiseVariance() const {
 template <typename Representer>
 const VectorType&
 StatisticalModel<Representer>::GetMeanVector() const {
-	return m_mean;
+	return *m_mean;
 }
 
 template <typename Representer>
@@ -437,18 +732,37 @@ StatisticalModel<Representer>::GetPCAVarianceVector() const {
 template <typename Representer>
 const MatrixType&
 StatisticalModel<Representer>::GetPCABasisMatrix() const {
-	return m_pcaBasisMatrix;
+	if (m_pcaBasisMatrix->cols() == GetNumberOfPrincipalComponents()) {
+		return *m_pcaBasisMatrix;
+	}
+
+	// the basis of a truncated model is shared with the original model, of which only the leading columns belong to
+	// the model. As a reference to a matrix is returned, these columns are copied once.
+#ifdef _OPENMP
+	#pragma omp critical(statismo_StatisticalModel_GetPCABasisMatrix)
+#endif
+	{
+		if (!m_truncatedPCABasisMatrix) {
+			m_truncatedPCABasisMatrix.reset(new MatrixType(GetPCABasisMatrixView()));
+		}
+	}
+	return *m_truncatedPCABasisMatrix;
 }
 
 template <typename Representer>
-MatrixType
-StatisticalModel<Representer>::GetOrthonormalPCABasisMatrix() const {
-	// we can recover the orthonormal matrix by undoing the scaling with the pcaVariance
-	// (c.f. the method SetParameters)
+ConstMatrixViewType
+StatisticalModel<Representer>::GetPCABasisMatrixView() const {
+	const MatrixType& basis = *m_pcaBasisMatrix;
+	return ConstMatrixViewType(basis.data(), basis.rows(), GetNumberOfPrincipalComponents(), Eigen::OuterStride<>(basis.cols()));
+}
 
-	assert(m_pcaVariance.maxCoeff() > 1e-8);
-	VectorType D = m_pcaVariance.array().sqrt();
-	return m_pcaBasisMatrix * DiagMatrixType(D).inverse();
+template <typename Representer>
+ConstScaledMatrixViewType
+StatisticalModel<Representer>::GetOrthonormalPCABasisMatrix() const {
+	// we recover the orthonormal matrix by undoing the scaling with the pcaVariance, whenever a coefficient is accessed
+	const MatrixType& W = *m_pcaBasisMatrix;
+	return ConstScaledMatrixViewType(Eigen::Block<const MatrixType>(W, 0, 0, W.rows(), GetNumberOfPrincipalComponents()),
+			Eigen::DiagonalWrapper<const VectorType>(m_inversePCAStandardDeviations));
 }
 
 
@@ -473,23 +787,19 @@ StatisticalModel<Representer>::GetModelInfo() const
 template <typename Representer>
 unsigned int
 StatisticalModel<Representer>::GetNumberOfPrincipalComponents() const {
-	return m_pcaBasisMatrix.cols();
+	return m_pcaVariance.rows();
 }
 
 template <typename Representer>
 MatrixType
 StatisticalModel<Representer>::GetJacobian(const PointType& pt) const {
 
-	unsigned Dimensions = Representer::GetDimensions();
-	MatrixType J = MatrixType::Zero(Dimensions, GetNumberOfPrincipalComponents());
-    
 	unsigned ptId = m_representer->GetPointIdForPoint(pt);
+	typename RepresenterTraitsType::PointIndexVectorType indices = GetPointIndices(ptId);
 
-	for(unsigned i = 0; i < Dimensions; i++) {
-        unsigned idx = Representer::MapPointIdToInternalIdx(ptId, i);
-		for(unsigned j = 0; j < GetNumberOfPrincipalComponents(); j++) {
-				 J(i,j) += m_pcaBasisMatrix(idx,j) ;
-        }
+	MatrixType J(indices.rows(), GetNumberOfPrincipalComponents());
+	for (unsigned i = 0; i < indices.rows(); i++) {
+		J.row(i) = GetPCABasisMatrixView().row(indices[i]);
 	}
 	return J;
 }
@@ -548,8 +858,12 @@ StatisticalModel<Representer>::Load(const H5::Group& modelRoot, unsigned maxNumb
 		representerGroup.close();
 
 		Group modelGroup = modelRoot.openGroup("./model");
-		HDF5Utils::readMatrix(modelGroup, "./pcaBasis", maxNumberOfPCAComponents, newModel->m_pcaBasisMatrix);
-		HDF5Utils::readVector(modelGroup, "./mean", newModel->m_mean);
+		shared_ptr<MatrixType> pcaBasisMatrix(new MatrixType);
+		HDF5Utils::readMatrix(modelGroup, "./pcaBasis", maxNumberOfPCAComponents, *pcaBasisMatrix);
+		newModel->m_pcaBasisMatrix = pcaBasisMatrix;
+		shared_ptr<VectorType> mean(new VectorType);
+		HDF5Utils::readVector(modelGroup, "./mean", *mean);
+		newModel->m_mean = mean;
 		HDF5Utils::readVector(modelGroup, "./pcaVariance", maxNumberOfPCAComponents, newModel->m_pcaVariance);
 		newModel->m_noiseVariance = HDF5Utils::readFloat(modelGroup, "./noiseVariance");
 
@@ -564,7 +878,7 @@ StatisticalModel<Representer>::Load(const H5::Group& modelRoot, unsigned maxNumb
 	}
 
 	assert(newModel != 0);
-	newModel->m_cachedValuesValid = false;
+	newModel->UpdateCachedParameters();
 
 	return newModel;
 }
@@ -606,9 +920,15 @@ StatisticalModel<Representer>::Save(const H5::Group& modelRoot) const {
 		representerGroup.close();
 
 		Group modelGroup = modelRoot.createGroup( "./model" );
-		HDF5Utils::writeMatrix(modelGroup, "./pcaBasis", m_pcaBasisMatrix);
+		// a truncated model only writes the leading columns of the shared basis, which then need to be copied
+		if (m_pcaBasisMatrix->cols() == GetNumberOfPrincipalComponents()) {
+			HDF5Utils::writeMatrix(modelGroup, "./pcaBasis", *m_pcaBasisMatrix);
+		}
+		else {
+			HDF5Utils::writeMatrix(modelGroup, "./pcaBasis", GetPCABasisMatrixView());
+		}
 		HDF5Utils::writeVector(modelGroup, "./pcaVariance", m_pcaVariance);
-		HDF5Utils::writeVector(modelGroup, "./mean", m_mean);
+		HDF5Utils::writeVector(modelGroup, "./mean", *m_mean);
 		HDF5Utils::writeFloat(modelGroup, "./noiseVariance", m_noiseVariance);
 		modelGroup.close();
 
@@ -623,17 +943,34 @@ StatisticalModel<Representer>::Save(const H5::Group& modelRoot) const {
 
 template <typename Representer>
 void
-StatisticalModel<Representer>::CheckAndUpdateCachedParameters() const {
+StatisticalModel<Representer>::UpdateCachedParameters() {
+	m_gramMatrix = MixedPrecision::TransposeTimesSelf(GetPCABasisMatrixView());
+	UpdateCachedParametersFromGramMatrix();
+}
+
+template <typename Representer>
+void
+StatisticalModel<Representer>::UpdateCachedParametersFromGramMatrix() {
+
+	// components with zero variance have a zero column in W, which stays zero in the orthonormal basis
+	m_inversePCAStandardDeviations.resize(GetNumberOfPrincipalComponents());
+	for (unsigned i = 0; i < GetNumberOfPrincipalComponents(); i++) {
+		m_inversePCAStandardDeviations[i] = m_pcaVariance[i] > 0 ? 1 / std::sqrt(m_pcaVariance[i]) : 0;
+	}
 
-	if (m_cachedValuesValid == false) {
-		VectorType I = VectorType::Ones(m_pcaBasisMatrix.cols());
-		MatrixType Mmatrix = m_pcaBasisMatrix.transpose() * m_pcaBasisMatrix;
-		Mmatrix.diagonal() += m_noiseVariance * I;
+	MatrixTypeDoublePrecision Mmatrix = m_gramMatrix;
+	Mmatrix.diagonal() += m_noiseVariance * VectorTypeDoublePrecision::Ones(GetNumberOfPrincipalComponents());
 
-		m_MInverseMatrix = Mmatrix.inverse();
+	m_MInverseMatrix = Mmatrix.inverse();
 
+	// by the matrix determinant lemma, |W W^T + sigma^2 I| = sigma^{2(p-k)} |M|. The determinant of M
+	// is computed from its cholesky factor.
+	m_logDetCovariance = 0;
+	if (m_noiseVariance > 0) {
+		Eigen::LLT<MatrixTypeDoublePrecision> llt(Mmatrix);
+		m_logDetCovariance = 2 * llt.matrixLLT().diagonal().array().log().sum()
+			+ (double(m_mean->rows()) - GetNumberOfPrincipalComponents()) * log(double(m_noiseVariance));
 	}
-	m_cachedValuesValid = true;
 }
 
 } // namespace statismo
@@ -0,0 +1,340 @@
+/*
+ * This file is part of the statismo library.
+ *
+ * Author: Marcel Luethi (marcel.luethi@unibas.ch)
+ *
+ * Copyright (c) 2011 University of Basel
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ *
+ * Neither the name of the project's author nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+ * TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS addINTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef __STREAMINGPCAMODELBUILDER_H_
+#define __STREAMINGPCAMODELBUILDER_H_
+
+#include "Config.h"
+#include "CommonTypes.h"
+#include "Exceptions.h"
+#include "HDF5Utils.h"
+#include "ModelInfo.h"
+#include "ModelBuilder.h"
+#include "StatisticalModel.h"
+#include "PCAKernels.h"
+#include <vector>
+#include <sstream>
+
+namespace statismo {
+
+
+/**
+ * \brief Reads blocks of columns of the data matrix, whose rows are the sample vectors, from files - internal use only.
+ */
+class SampleColumnReader {
+public:
+	virtual ~SampleColumnReader() {}
+
+	/// the number of samples n
+	virtual unsigned GetNumberOfSamples() const = 0;
+
+	/// the dimension p of the sample vectors
+	virtual unsigned GetNumberOfColumns() const = 0;
+
+	/// reads the elements firstCol, ..., firstCol + nCols - 1 of all the sample vectors into the rows of block
+	virtual void ReadColumns(unsigned firstCol, unsigned nCols, MatrixType& block) const = 0;
+
+	/// returns the URI of the i-th sample
+	virtual std::string GetURI(unsigned i) const = 0;
+};
+
+
+/**
+ * \brief Reads the samples from a file that was written by DataManager::Save.
+ *
+ * Only the requested elements of the sample vectors are read from the file.
+ */
+class DataManagerFileColumnReader : public SampleColumnReader {
+public:
+	DataManagerFileColumnReader(const H5::H5File& file) : m_file(file) {
+		H5::Group publicGroup = m_file.openGroup("/data");
+		m_numberOfSamples = HDF5Utils::readInt(publicGroup, "./NumberOfDatasets");
+		publicGroup.close();
+		if (m_numberOfSamples == 0) {
+			throw StatisticalModelException("The data manager file does not contain any datasets");
+		}
+
+		H5::Group dsGroup = m_file.openGroup(GetGroupName(0).c_str());
+		H5::DataSet ds = dsGroup.openDataSet("./samplevector");
+		hsize_t dims[1];
+		ds.getSpace().getSimpleExtentDims(dims, NULL);
+		m_numberOfColumns = static_cast<unsigned>(dims[0]);
+	}
+
+	unsigned GetNumberOfSamples() const { return m_numberOfSamples; }
+	unsigned GetNumberOfColumns() const { return m_numberOfColumns; }
+
+	void ReadColumns(unsigned firstCol, unsigned nCols, MatrixType& block) const {
+		block.resize(m_numberOfSamples, nCols);
+		VectorType elements;
+		for (unsigned i = 0; i < m_numberOfSamples; i++) {
+			H5::Group dsGroup = m_file.openGroup(GetGroupName(i).c_str());
+			HDF5Utils::readVectorElements(dsGroup, "./samplevector", firstCol, nCols, elements);
+			block.row(i) = elements;
+		}
+	}
+
+	std::string GetURI(unsigned i) const {
+		H5::Group dsGroup = m_file.openGroup(GetGroupName(i).c_str());
+		return HDF5Utils::readString(dsGroup, "./URI");
+	}
+
+private:
+	static std::string GetGroupName(unsigned i) {
+		std::ostringstream ss;
+		ss << "./dataset-" << i;
+		return ss.str();
+	}
+
+	H5::H5File m_file;
+	unsigned m_numberOfSamples;
+	unsigned m_numberOfColumns;
+};
+
+
+/**
+ * \brief Reads the samples from a list of dataset files, using Representer::ReadDataset.
+ *
+ * A dataset file can only be read as a whole. Each file is therefore read once for every block of columns.
+ */
+template <typename Representer>
+class FileListColumnReader : public SampleColumnReader {
+public:
+	FileListColumnReader(const Representer* representer, const std::vector<std::string>& filenames)
+	: m_representer(representer), m_filenames(filenames)
+	{
+		if (m_filenames.size() == 0) {
+			throw StatisticalModelException("Provided empty file list");
+		}
+		m_numberOfColumns = ReadSampleVector(0).rows();
+	}
+
+	unsigned GetNumberOfSamples() const { return m_filenames.size(); }
+	unsigned GetNumberOfColumns() const { return m_numberOfColumns; }
+
+	void ReadColumns(unsigned firstCol, unsigned nCols, MatrixType& block) const {
+		block.resize(m_filenames.size(), nCols);
+		for (unsigned i = 0; i < m_filenames.size(); i++) {
+			VectorType sampleVector = ReadSampleVector(i);
+			if (sampleVector.rows() != m_numberOfColumns) {
+				throw StatisticalModelException((std::string("The sample has a different dimension than the others: ") + m_filenames[i]).c_str());
+			}
+			block.row(i) = sampleVector.segment(firstCol, nCols);
+		}
+	}
+
+	std::string GetURI(unsigned i) const { return m_filenames[i]; }
+
+private:
+	VectorType ReadSampleVector(unsigned i) const {
+		typename Representer::DatasetPointerType dataset = Representer::ReadDataset(m_filenames[i].c_str());
+		typename Representer::DatasetPointerType sample = m_representer->DatasetToSample(dataset, 0);
+		VectorType sampleVector = m_representer->SampleToSampleVector(sample);
+		Representer::DeleteDataset(sample);
+		Representer::DeleteDataset(dataset);
+		return sampleVector;
+	}
+
+	const Representer* m_representer;
+	std::vector<std::string> m_filenames;
+	unsigned m_numberOfColumns;
+};
+
+
+
+/**
+ * \brief Creates StatisticalModel using Principal Component Analysis, without holding the data in memory.
+ *
+ * In contrast to the PCAModelBuilder, the samples are not loaded into memory, but streamed from disk: either from a file
+ * that was written by DataManager::Save, or from a list of dataset files. The data is read in blocks of columns (i.e. a
+ * block of elements of all the sample vectors), which are centered with their own mean. The size of the blocks is
+ * determined by SetMemoryLimitInMB. The model is written directly to a model file, with the mean and the basis written
+ * block by block of rows. Hence, neither the data nor the model are ever completely in memory. The model can then be
+ * loaded with StatisticalModel::Load.
+ *
+ * The principal components are computed with one of the following methods:
+ * - GRAM_MATRIX: The n x n inner product (Gram) matrix of the centered data is accumulated over the blocks and decomposed.
+ *   A second pass over the data reconstructs the basis. This computes the exact principal components.
+ * - SKETCH: The data is read only once. For each block, three random projections (sketches) of the data are accumulated:
+ *   of its range (n x l), of its co-range (l x p) and a core sketch (s x s, with s = 2l + 1). The co-range sketch is written
+ *   to a scratch file next to the model file, and the basis is computed from it. This only computes the leading principal
+ *   components (see SetMaxNumberOfComponents) and is approximate. The accuracy depends on the sketch size l (see SetSketchSize)
+ *   relative to the decay of the spectrum of the data: The variance of the components that are not captured by the sketches
+ *   is partly attributed to the computed components. Their variances are therefore biased upwards, and their directions
+ *   are perturbed, if the spectrum has a heavy tail (i.e. if many components have a variance comparable to the ones that
+ *   are computed). In this case, the sketch size should be increased, or the GRAM_MATRIX method used. For details, see
+ *   Streaming low-rank matrix approximation with an application to scientific simulation, J. Tropp, A. Yurtsever,
+ *   M. Udell and V. Cevher, SIAM J. Sci. Comput. 41(4), 2019
+ *
+ * The products with the blocks of the data are computed in parallel, as in the PCAModelBuilder (see SetNumberOfThreads).
+ * The scores of the samples are not computed, as this would require another pass over the data.
+ * If the build fails, the partially written model file (and the scratch file) are removed.
+ */
+template <typename Representer>
+class StreamingPCAModelBuilder : public ModelBuilder<Representer> {
+
+
+public:
+
+	typedef ModelBuilder<Representer> Superclass;
+	typedef typename Superclass::StatisticalModelType StatisticalModelType;
+
+	/// The method used to compute the principal components (see the class description)
+	enum MethodType {
+		GRAM_MATRIX,
+		SKETCH
+	};
+
+	/// The number of additional directions that are sampled by the sketch (see SetSketchSize)
+	enum { SKETCH_OVERSAMPLING = 10 };
+
+	/**
+	 * Factory method to create a new StreamingPCAModelBuilder
+	 * \param method The method used to compute the principal components
+	 */
+	static StreamingPCAModelBuilder* Create(MethodType method = GRAM_MATRIX) { return new StreamingPCAModelBuilder(method); }
+
+	/**
+	 * Destroy the object.
+	 * The same effect can be achieved by deleting the object in the usual
+	 * way using the c++ delete keyword.
+	 */
+	void Delete() {delete this; }
+
+
+	/**
+	 * The desctructor
+	 */
+	virtual ~StreamingPCAModelBuilder() {}
+
+	/**
+	 * Build a new model from the data in a file, which was written by DataManager::Save, and save it to a model file.
+	 * \param dataManagerFilename The file holding the data
+	 * \param modelFilename The file to which the model is written
+	 * \param noiseVariance The variance of N(0, noiseVariance) distributed noise on the points.
+	 * If this parameter is set to 0, we have a standard PCA model. For values > 0 we have a PPCA model.
+	 */
+	void BuildNewModelFromDataManagerFile(const std::string& dataManagerFilename, const std::string& modelFilename, double noiseVariance) const;
+
+	/**
+	 * Build a new model from a list of dataset files and save it to a model file.
+	 * The datasets are read with Representer::ReadDataset and converted to samples with the given representer,
+	 * as in DataManager::AddDataset.
+	 * \param representer The representer
+	 * \param filenames The dataset files
+	 * \param modelFilename The file to which the model is written
+	 * \param noiseVariance The variance of N(0, noiseVariance) distributed noise on the points.
+	 */
+	void BuildNewModelFromFileList(const Representer* representer, const std::vector<std::string>& filenames, const std::string& modelFilename, double noiseVariance) const;
+
+	/**
+	 * Limits the number of principal components of the models that are built. By default, all the components are kept.
+	 * For the SKETCH method, the limit should be set, as the size of the sketch is proportional to the number of components.
+	 */
+	void SetMaxNumberOfComponents(unsigned maxNumberOfComponents) { m_maxNumberOfComponents = maxNumberOfComponents; }
+
+	/**
+	 * Keep only as many principal components as are needed to explain the given fraction of the total variance
+	 * of the data. The default value of 1 keeps all the components.
+	 * For the SKETCH method, the fraction refers to the components that are computed (see SetMaxNumberOfComponents).
+	 */
+	void SetVarianceRetained(double varianceRetained) { m_varianceRetained = varianceRetained; }
+
+	/**
+	 * Sets the memory (in megabytes) for a block of the data. The blocks hold as many elements of each sample vector as fit
+	 * into this memory. The default is 256 megabytes. For a list of dataset files, fewer (i.e. larger) blocks mean that the files
+	 * are read fewer times.
+	 */
+	void SetMemoryLimitInMB(double memoryLimitInMB) { m_memoryLimitInMB = memoryLimitInMB; }
+
+	/**
+	 * Sets the size l of the range and co-range sketches of the SKETCH method. Larger sketches are more accurate, in particular
+	 * if the spectrum of the data decays slowly, but need more memory (O(nl + l^2)) and scratch space (pl).
+	 * The default value of 0 uses l = 4k + SKETCH_OVERSAMPLING for k components. The size is limited to the number of samples.
+	 */
+	void SetSketchSize(unsigned sketchSize) { m_sketchSize = sketchSize; }
+
+	/**
+	 * Sets the number of threads that are used to compute the products with the data. The default value of 0 uses
+	 * as many threads as OpenMP provides. Without OpenMP, the products are always computed by a single thread.
+	 */
+	void SetNumberOfThreads(unsigned numberOfThreads) { m_numberOfThreads = numberOfThreads; }
+
+
+private:
+	// to prevent use
+	StreamingPCAModelBuilder(MethodType method);
+	StreamingPCAModelBuilder(const StreamingPCAModelBuilder& orig);
+	StreamingPCAModelBuilder& operator=(const StreamingPCAModelBuilder& rhs);
+
+	void BuildNewModelInternal(const Representer* representer, const SampleColumnReader& reader, const std::string& modelFilename, double noiseVariance) const;
+
+	// computes the principal components with the Gram matrix. The mean and the basis are written to the model group.
+	void ComputeGramMatrixPCA(const SampleColumnReader& reader, const H5::Group& modelGroup, double noiseVariance, VectorType& pcaVariance) const;
+
+	// computes the principal components with the sketch. The mean and the basis are written to the model group.
+	void ComputeSketchPCA(const SampleColumnReader& reader, const H5::Group& modelGroup, const std::string& scratchFilename, double noiseVariance, VectorType& pcaVariance) const;
+
+	// returns the size of the range and co-range sketches for the given number of components
+	unsigned GetSketchSize(unsigned numberOfComponents, unsigned n, unsigned p) const;
+
+	// reads a block of columns and centers it. The mean of the columns is returned in meanBlock.
+	// Returns the squared norm of the centered block.
+	static double ReadCenteredColumns(const SampleColumnReader& reader, unsigned firstCol, unsigned nCols, MatrixTypeDoublePrecision& block, VectorType& meanBlock);
+
+	// returns the number of columns of a block, given the memory limit
+	unsigned GetNumberOfColumnsPerBlock(unsigned n, unsigned p) const;
+
+	// returns the number of components that are kept, given the variances in descending order and the total variance
+	// of the data (see PCAKernels::GetNumberOfComponentsToKeep)
+	unsigned GetNumberOfComponentsToKeep(const VectorTypeDoublePrecision& variances, double totalVariance, unsigned n, unsigned p, double noiseVariance) const;
+
+	MethodType m_method;
+	unsigned m_maxNumberOfComponents;
+	double m_varianceRetained;
+	double m_memoryLimitInMB;
+	unsigned m_sketchSize;
+	unsigned m_numberOfThreads;
+};
+
+
+
+} // namespace statismo
+
+#include "StreamingPCAModelBuilder.txx"
+
+#endif /* __STREAMINGPCAMODELBUILDER_H_ */
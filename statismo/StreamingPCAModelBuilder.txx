@@ -0,0 +1,439 @@
+/*
+ * This file is part of the statismo library.
+ *
+ * Author: Marcel Luethi (marcel.luethi@unibas.ch)
+ *
+ * Copyright (c) 2011 University of Basel
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ *
+ * Neither the name of the project's author nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+ * TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS addINTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include <Eigen/SVD>
+#include <Eigen/Eigenvalues>
+#include <Eigen/QR>
+#include "CommonTypes.h"
+#include "Exceptions.h"
+#include "utils.h"
+#include <cstdio>
+#include <limits>
+
+
+
+namespace statismo {
+
+
+
+
+template <typename Representer>
+StreamingPCAModelBuilder<Representer>::StreamingPCAModelBuilder(MethodType method)
+: Superclass(),
+  m_method(method),
+  m_maxNumberOfComponents(std::numeric_limits<unsigned>::max()),
+  m_varianceRetained(1.0),
+  m_memoryLimitInMB(256),
+  m_sketchSize(0),
+  m_numberOfThreads(0)
+  {}
+
+
+template <typename Representer>
+void
+StreamingPCAModelBuilder<Representer>::BuildNewModelFromDataManagerFile(const std::string& dataManagerFilename, const std::string& modelFilename, double noiseVariance) const
+{
+	using namespace H5;
+
+	H5File file;
+	try {
+		file = H5File(dataManagerFilename.c_str(), H5F_ACC_RDONLY);
+	}
+	catch (H5::Exception& e) {
+		 std::string msg(std::string("could not open HDF5 file \n") + e.getCDetailMsg());
+		 throw StatisticalModelException(msg.c_str());
+	}
+
+	Representer* representer = 0;
+	try {
+		Group representerGroup = file.openGroup("/representer");
+		std::string rep_name = HDF5Utils::readStringAttribute(representerGroup, "name");
+		if (rep_name != Representer::GetName()) {
+			throw StatisticalModelException("A different representer was used to create the file. Cannot load hdf5 file.");
+		}
+		representer = Representer::Load(representerGroup);
+		representerGroup.close();
+
+		DataManagerFileColumnReader reader(file);
+		BuildNewModelInternal(representer, reader, modelFilename, noiseVariance);
+	}
+	catch (H5::Exception& e) {
+		if (representer != 0) {
+			representer->Delete();
+		}
+		std::string msg(std::string("an exception occurred while reading the data manager file \n") + e.getCDetailMsg());
+		throw StatisticalModelException(msg.c_str());
+	}
+	catch (StatisticalModelException&) {
+		if (representer != 0) {
+			representer->Delete();
+		}
+		throw;
+	}
+
+	representer->Delete();
+	file.close();
+}
+
+
+template <typename Representer>
+void
+StreamingPCAModelBuilder<Representer>::BuildNewModelFromFileList(const Representer* representer, const std::vector<std::string>& filenames, const std::string& modelFilename, double noiseVariance) const
+{
+	FileListColumnReader<Representer> reader(representer, filenames);
+	try {
+		BuildNewModelInternal(representer, reader, modelFilename, noiseVariance);
+	}
+	catch (H5::Exception& e) {
+		std::string msg(std::string("an exception occurred while writing the model file \n") + e.getCDetailMsg());
+		throw StatisticalModelException(msg.c_str());
+	}
+}
+
+
+template <typename Representer>
+void
+StreamingPCAModelBuilder<Representer>::BuildNewModelInternal(const Representer* representer, const SampleColumnReader& reader, const std::string& modelFilename, double noiseVariance) const
+{
+	using namespace H5;
+
+	unsigned n = reader.GetNumberOfSamples();
+	if (n < 2) {
+		throw StatisticalModelException("At least two samples are needed to build a model");
+	}
+
+	H5File file;
+	try {
+		file = H5File(modelFilename.c_str(), H5F_ACC_TRUNC);
+	} catch (H5::Exception& e) {
+		std::string msg(std::string("Could not open HDF5 file for writing \n") + e.getCDetailMsg());
+		throw StatisticalModelException(msg.c_str());
+	}
+
+	// if the build fails, the partially written model file is removed
+	try {
+		// the model file has the same structure as the one written by StatisticalModel::Save
+		Group modelRoot = file.openGroup("/");
+		Group representerGroup = modelRoot.createGroup("./representer");
+		HDF5Utils::writeStringAttribute(representerGroup, "name", Representer::GetName());
+		representer->Save(representerGroup);
+		representerGroup.close();
+
+		Group modelGroup = modelRoot.createGroup("./model");
+		VectorType pcaVariance;
+		std::string methodName;
+		if (m_method == SKETCH) {
+			ComputeSketchPCA(reader, modelGroup, modelFilename + ".sketch", noiseVariance, pcaVariance);
+			methodName = "Sketch";
+		}
+		else {
+			ComputeGramMatrixPCA(reader, modelGroup, noiseVariance, pcaVariance);
+			methodName = "GramMatrix";
+		}
+		HDF5Utils::writeVector(modelGroup, "./pcaVariance", pcaVariance);
+		HDF5Utils::writeFloat(modelGroup, "./noiseVariance", noiseVariance);
+		modelGroup.close();
+
+
+		typename BuilderInfo::ParameterInfoList bi;
+		bi.push_back(BuilderInfo::KeyValuePair("NoiseVariance ", Utils::toString(noiseVariance)));
+		bi.push_back(BuilderInfo::KeyValuePair("Method ", methodName));
+
+		typename BuilderInfo::DataInfoList dataInfo;
+		for (unsigned i = 0; i < n; i++) {
+			std::ostringstream os;
+			os << "URI_" << i;
+			dataInfo.push_back(BuilderInfo::KeyValuePair(os.str().c_str(), reader.GetURI(i)));
+		}
+
+		// finally add meta data to the model info. The scores are not computed.
+		BuilderInfo builderInfo("StreamingPCAModelBuilder", dataInfo, bi);
+
+		ModelInfo::BuilderInfoList biList;
+		biList.push_back(builderInfo);
+
+		ModelInfo info(MatrixType(), biList);
+		info.Save(modelRoot);
+
+		modelRoot.close();
+	}
+	catch (...) {
+		file.close();
+		std::remove(modelFilename.c_str());
+		throw;
+	}
+	file.close();
+}
+
+
+template <typename Representer>
+void
+StreamingPCAModelBuilder<Representer>::ComputeGramMatrixPCA(const SampleColumnReader& reader, const H5::Group& modelGroup, double noiseVariance, VectorType& pcaVariance) const
+{
+	unsigned n = reader.GetNumberOfSamples();
+	unsigned p = reader.GetNumberOfColumns();
+	unsigned blockSize = GetNumberOfColumnsPerBlock(n, p);
+
+	// first pass: the Gram matrix X0 X0^T is accumulated over the blocks of columns, as in the PCAModelBuilder
+	HDF5Utils::createVector(modelGroup, "./mean", p);
+	MatrixTypeDoublePrecision G = MatrixTypeDoublePrecision::Zero(n, n);
+	MatrixTypeDoublePrecision block;
+	VectorType meanBlock;
+	double squaredNorm = 0;
+	for (unsigned j = 0; j < p; j += blockSize) {
+		unsigned nCols = std::min(blockSize, p - j);
+		squaredNorm += ReadCenteredColumns(reader, j, nCols, block, meanBlock);
+		HDF5Utils::writeVectorElements(modelGroup, "./mean", j, meanBlock);
+		PCAKernels::AddLowerTriangleOfTimesTransposeSelf(block, G, m_numberOfThreads);
+	}
+	PCAKernels::CopyLowerToUpperTriangle(G);
+	G /= (n - 1);
+
+	VectorTypeDoublePrecision eigenvalues;
+	MatrixTypeDoublePrecision V;
+	PCAKernels::ComputeEigenDecomposition(G, false, eigenvalues, V);
+
+	unsigned numComponentsToKeep = GetNumberOfComponentsToKeep(eigenvalues, squaredNorm / (n - 1), n, p, noiseVariance);
+
+	// as in the PCAModelBuilder, the eigenvectors U of the covariance matrix are recovered from the eigenvectors V
+	// of the Gram matrix as U = X0^T V D^{-1/2} / sqrt(n-1). The model file holds the basis scaled with the standard
+	// deviations (see StatisticalModel::GetPCABasisMatrix), which is written directly.
+	pcaVariance = (eigenvalues.topRows(numComponentsToKeep).array() - noiseVariance).cast<ScalarType>();
+	MatrixTypeDoublePrecision VScaled(n, numComponentsToKeep);
+	for (unsigned i = 0; i < numComponentsToKeep; i++) {
+		VScaled.col(i) = V.col(i) * std::sqrt(pcaVariance(i) / (eigenvalues(i) * (n - 1)));
+	}
+
+	// second pass: the basis is computed and written block by block of rows
+	HDF5Utils::createMatrix(modelGroup, "./pcaBasis", p, numComponentsToKeep);
+	MatrixType basisBlock;
+	for (unsigned j = 0; j < p; j += blockSize) {
+		unsigned nCols = std::min(blockSize, p - j);
+		ReadCenteredColumns(reader, j, nCols, block, meanBlock);
+		basisBlock.resize(nCols, numComponentsToKeep);
+		PCAKernels::TransposeTimesIntoRows(block, VScaled, 0, basisBlock, m_numberOfThreads);
+		HDF5Utils::writeMatrixRows(modelGroup, "./pcaBasis", j, basisBlock);
+	}
+}
+
+
+template <typename Representer>
+void
+StreamingPCAModelBuilder<Representer>::ComputeSketchPCA(const SampleColumnReader& reader, const H5::Group& modelGroup, const std::string& scratchFilename, double noiseVariance, VectorType& pcaVariance) const
+{
+	unsigned n = reader.GetNumberOfSamples();
+	unsigned p = reader.GetNumberOfColumns();
+	unsigned blockSize = GetNumberOfColumnsPerBlock(n, p);
+
+	// We use the three sketches of Tropp et al. (2019), with Gaussian test matrices:
+	// the range sketch Y = X0 Omega (n x l), the co-range sketch W = Upsilon X0 (l x p) and the core sketch
+	// Z = Phi X0 Psi^T (s x s). Omega and Psi have p rows. They are drawn block by block (one stream per block) and never stored.
+	// The random numbers are always drawn with the same seeds, such that the builds are reproducible.
+	unsigned k = std::min(m_maxNumberOfComponents, std::min(n - 1, p));
+	unsigned l = GetSketchSize(k, n, p);
+	unsigned s = 2 * l + 1;
+
+	// Upsilon and Phi are stored transposed, such that the products with a block are computed as X0^T Upsilon^T and
+	// X0^T Phi^T by the parallel kernels (see PCAKernels)
+	RandomStream stream(0);
+	MatrixTypeDoublePrecision UpsilonTransposed = Utils::generateNormalMatrix(l, n, stream).cast<double>().transpose();
+	MatrixTypeDoublePrecision PhiTransposed = Utils::generateNormalMatrix(s, n, stream).cast<double>().transpose();
+
+	// The single pass over the data. The co-range sketch W is written to a scratch file. Of W, only W W^T and Psi W^T are kept.
+	H5::H5File scratchFile;
+	try {
+		scratchFile = H5::H5File(scratchFilename.c_str(), H5F_ACC_TRUNC);
+	} catch (H5::Exception& e) {
+		std::string msg(std::string("Could not open the scratch file for writing \n") + e.getCDetailMsg());
+		throw StatisticalModelException(msg.c_str());
+	}
+
+	// the scratch file is removed, whether the computation succeeds or not
+	try {
+		H5::Group scratchGroup = scratchFile.openGroup("/");
+		HDF5Utils::createMatrix(scratchGroup, "./sketch", p, l);
+
+		HDF5Utils::createVector(modelGroup, "./mean", p);
+		MatrixTypeDoublePrecision Y = MatrixTypeDoublePrecision::Zero(n, l);
+		MatrixTypeDoublePrecision Z = MatrixTypeDoublePrecision::Zero(s, s);
+		MatrixTypeDoublePrecision WWt = MatrixTypeDoublePrecision::Zero(l, l);
+		MatrixTypeDoublePrecision PsiWt = MatrixTypeDoublePrecision::Zero(s, l);
+		MatrixTypeDoublePrecision block;
+		MatrixTypeDoublePrecision WBlockTransposed;
+		MatrixTypeDoublePrecision PhiBlockTransposed;
+		VectorType meanBlock;
+		double squaredNorm = 0;
+		for (unsigned j = 0, b = 0; j < p; j += blockSize, b++) {
+			unsigned nCols = std::min(blockSize, p - j);
+			squaredNorm += ReadCenteredColumns(reader, j, nCols, block, meanBlock);
+			HDF5Utils::writeVectorElements(modelGroup, "./mean", j, meanBlock);
+
+			RandomStream blockStream(0, b + 1);
+			MatrixTypeDoublePrecision Omega = Utils::generateNormalMatrix(nCols, l, blockStream).cast<double>();
+			MatrixTypeDoublePrecision Psi = Utils::generateNormalMatrix(s, nCols, blockStream).cast<double>();
+
+			// the products with the block, whose inner dimension is n
+			PCAKernels::AddTimes(block, Omega, Y, m_numberOfThreads);
+			WBlockTransposed.resize(nCols, l);
+			PCAKernels::TransposeTimesIntoRows(block, UpsilonTransposed, 0, WBlockTransposed, m_numberOfThreads);
+			PhiBlockTransposed.resize(nCols, s);
+			PCAKernels::TransposeTimesIntoRows(block, PhiTransposed, 0, PhiBlockTransposed, m_numberOfThreads);
+
+			Z.noalias() += PhiBlockTransposed.transpose() * Psi.transpose();
+			WWt.noalias() += WBlockTransposed.transpose() * WBlockTransposed;
+			PsiWt.noalias() += Psi * WBlockTransposed;
+			MatrixType WBlockTransposedSingle = WBlockTransposed.cast<ScalarType>();
+			HDF5Utils::writeMatrixRows(scratchGroup, "./sketch", j, WBlockTransposedSingle);
+		}
+
+		// Q is an orthonormal basis of the range of Y, and P = W^T T an orthonormal basis of the range of W^T. P cannot be
+		// formed in memory (it is p x l), but T is obtained from the eigendecomposition W W^T = E L E^T as T = E L^{-1/2}.
+		// Directions with vanishing eigenvalues (if l exceeds the rank of the data) are dropped.
+		Eigen::HouseholderQR<MatrixTypeDoublePrecision> qr(Y);
+		MatrixTypeDoublePrecision Q = qr.householderQ() * MatrixTypeDoublePrecision::Identity(n, l);
+
+		VectorTypeDoublePrecision L;
+		MatrixTypeDoublePrecision E;
+		PCAKernels::ComputeEigenDecomposition(WWt, false, L, E);
+		unsigned rankW = 0;
+		while (rankW < l && L(rankW) > L(0) * 1e-12) {
+			rankW++;
+		}
+		MatrixTypeDoublePrecision T(l, rankW);
+		for (unsigned i = 0; i < rankW; i++) {
+			T.col(i) = E.col(i) / std::sqrt(L(i));
+		}
+
+		// The core matrix C = (Phi Q)^+ Z ((Psi P)^+)^T gives the approximation X0 ~ Q C P^T. With the SVD C = U S V^T,
+		// the principal directions are P V = W^T T V, and the variances S^2 / (n-1).
+		MatrixTypeDoublePrecision PhiQ = PhiTransposed.transpose() * Q;
+		MatrixTypeDoublePrecision PsiP = PsiWt * T;
+		Eigen::JacobiSVD<MatrixTypeDoublePrecision> phiQSVD(PhiQ, Eigen::ComputeThinU | Eigen::ComputeThinV);
+		Eigen::JacobiSVD<MatrixTypeDoublePrecision> psiPSVD(PsiP, Eigen::ComputeThinU | Eigen::ComputeThinV);
+		MatrixTypeDoublePrecision PhiQZ = phiQSVD.solve(Z);
+		MatrixTypeDoublePrecision C = psiPSVD.solve(PhiQZ.transpose()).transpose();
+
+		Eigen::JacobiSVD<MatrixTypeDoublePrecision> coreSVD(C, Eigen::ComputeThinU | Eigen::ComputeThinV);
+		VectorTypeDoublePrecision S = coreSVD.singularValues();
+		unsigned numberOfSingularValues = std::min(k, unsigned(S.rows()));
+		VectorTypeDoublePrecision eigenvalues = S.topRows(numberOfSingularValues).array().square() / (n - 1);
+
+		unsigned numComponentsToKeep = GetNumberOfComponentsToKeep(eigenvalues, squaredNorm / (n - 1), n, p, noiseVariance);
+		pcaVariance = (eigenvalues.topRows(numComponentsToKeep).array() - noiseVariance).cast<ScalarType>();
+
+		// as for the Gram matrix, the basis is scaled with the standard deviations
+		MatrixTypeDoublePrecision TV = T * coreSVD.matrixV().leftCols(numComponentsToKeep);
+		for (unsigned i = 0; i < numComponentsToKeep; i++) {
+			TV.col(i) *= std::sqrt(double(pcaVariance(i)));
+		}
+
+		// the basis is computed block by block of rows from the sketch W, without another pass over the data
+		HDF5Utils::createMatrix(modelGroup, "./pcaBasis", p, numComponentsToKeep);
+		MatrixType WtBlock;
+		for (unsigned j = 0; j < p; j += blockSize) {
+			unsigned nRows = std::min(blockSize, p - j);
+			HDF5Utils::readMatrixRows(scratchGroup, "./sketch", j, nRows, WtBlock);
+			MatrixType basisBlock = (WtBlock.cast<double>() * TV).cast<ScalarType>();
+			HDF5Utils::writeMatrixRows(modelGroup, "./pcaBasis", j, basisBlock);
+		}
+
+		scratchGroup.close();
+	}
+	catch (...) {
+		scratchFile.close();
+		std::remove(scratchFilename.c_str());
+		throw;
+	}
+
+	scratchFile.close();
+	std::remove(scratchFilename.c_str());
+}
+
+
+template <typename Representer>
+unsigned
+StreamingPCAModelBuilder<Representer>::GetSketchSize(unsigned numberOfComponents, unsigned n, unsigned p) const
+{
+	unsigned l = (m_sketchSize > 0) ? m_sketchSize : 4 * numberOfComponents + SKETCH_OVERSAMPLING;
+	return std::max(numberOfComponents, std::min(l, std::min(n, p)));
+}
+
+
+template <typename Representer>
+double
+StreamingPCAModelBuilder<Representer>::ReadCenteredColumns(const SampleColumnReader& reader, unsigned firstCol, unsigned nCols, MatrixTypeDoublePrecision& block, VectorType& meanBlock)
+{
+	MatrixType X;
+	reader.ReadColumns(firstCol, nCols, X);
+	block = X.cast<double>();
+
+	// the mean of each element only depends on the elements of the block. The block can thus be centered on its own.
+	VectorTypeDoublePrecision mean = block.colwise().mean().transpose();
+	for (unsigned i = 0; i < block.rows(); i++) {
+		block.row(i) -= mean.transpose();
+	}
+	meanBlock = mean.cast<ScalarType>();
+	return block.squaredNorm();
+}
+
+
+template <typename Representer>
+unsigned
+StreamingPCAModelBuilder<Representer>::GetNumberOfColumnsPerBlock(unsigned n, unsigned p) const
+{
+	// a block is held in single and double precision
+	double bytesPerColumn = (sizeof(ScalarType) + sizeof(double)) * double(n);
+	double numberOfColumns = m_memoryLimitInMB * 1024 * 1024 / bytesPerColumn;
+	return static_cast<unsigned>(std::max(1.0, std::min(double(p), numberOfColumns)));
+}
+
+
+template <typename Representer>
+unsigned
+StreamingPCAModelBuilder<Representer>::GetNumberOfComponentsToKeep(const VectorTypeDoublePrecision& variances, double totalVariance, unsigned n, unsigned p, double noiseVariance) const
+{
+	unsigned numComponents = PCAKernels::GetNumberOfComponentsToKeep(variances, totalVariance, std::min(n - 1, p), noiseVariance,
+			m_maxNumberOfComponents, m_varianceRetained, Superclass::TOLERANCE);
+
+	if (numComponents == 0) {
+		throw StatisticalModelException("All the eigenvalues are below the given tolerance. Model cannot be built.");
+	}
+	return numComponents;
+}
+
+
+} // namespace statismo
@@ -0,0 +1,163 @@
+/*
+ * This file is part of the statismo library.
+ *
+ * Author: Marcel Luethi (marcel.luethi@unibas.ch)
+ *
+ * Copyright (c) 2011 University of Basel
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ *
+ * Neither the name of the project's author nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+ * TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS addINTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#ifndef __SUBSETREPRESENTER_H_
+#define __SUBSETREPRESENTER_H_
+
+#include "Config.h"
+#include "CommonTypes.h"
+#include "Domain.h"
+#include "RepresenterTraits.h"
+#include "HDF5Utils.h"
+#include <H5Cpp.h>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace statismo {
+
+
+/**
+ * \brief A representer for the restriction of the datasets of another representer to a subset of their points.
+ *
+ * The i-th point of the subset corresponds to the point with id pointIds[i] of the underlying representer.
+ * The datasets are the same as those of the underlying representer, but the sample vector only contains the values of the
+ * points in the subset (in the order of the subset, with the d-th component of the i-th point at position i * GetDimensions() + d).
+ *
+ * To convert a sample vector back into a dataset of the underlying representer, the values of the points outside the subset
+ * are taken from a reference sample vector (typically the mean of the model from which the subset was extracted).
+ *
+ * This representer is used by the MarginalModelBuilder.
+ */
+template <typename Representer>
+class SubsetRepresenter {
+public:
+
+	typedef Representer UnderlyingRepresenterType;
+	typedef typename Representer::DatasetPointerType DatasetPointerType;
+	typedef typename Representer::DatasetConstPointerType DatasetConstPointerType;
+	typedef typename Representer::PointType PointType;
+	typedef typename Representer::ValueType ValueType;
+	typedef typename Representer::DatasetInfo DatasetInfo;
+	typedef Domain<PointType> DomainType;
+	typedef std::vector<unsigned> PointIdListType;
+
+	/**
+	 * Creates a new representer
+	 * \param representer The underlying representer. The representer is cloned.
+	 * \param pointIds The ids of the points (w.r.t. the underlying representer) that form the subset
+	 * \param referenceSampleVector A sample vector of the underlying representer, that defines the values outside of the subset
+	 */
+	static SubsetRepresenter* Create(const Representer* representer, const PointIdListType& pointIds, const VectorType& referenceSampleVector) {
+		return new SubsetRepresenter(representer->Clone(), pointIds, referenceSampleVector);
+	}
+
+	static SubsetRepresenter* Load(const H5::CommonFG& fg);
+
+	SubsetRepresenter* Clone() const { return SubsetRepresenter::Create(m_representer, m_pointIds, m_referenceSampleVector); }
+	void Delete() const { delete this; }
+
+	virtual ~SubsetRepresenter() {
+		// not all representers can implement a const correct version of delete.
+		const_cast<Representer*>(m_representer)->Delete();
+	}
+
+	static std::string GetName() { return "SubsetRepresenter(" + Representer::GetName() + ")"; }
+	enum { Dimensions = RepresenterTraits<Representer>::Dimensions };
+	static unsigned GetDimensions() { return Representer::GetDimensions(); }
+
+	const DomainType& GetDomain() const { return m_domain; }
+
+	/** \return The underlying representer */
+	const Representer* GetUnderlyingRepresenter() const { return m_representer; }
+
+	/** \return The ids of the points of the subset, w.r.t. the underlying representer */
+	const PointIdListType& GetPointIds() const { return m_pointIds; }
+
+	DatasetPointerType DatasetToSample(DatasetConstPointerType ds, DatasetInfo* dsInfo) const {
+		return m_representer->DatasetToSample(ds, dsInfo);
+	}
+
+	VectorType SampleToSampleVector(DatasetConstPointerType sample) const;
+	DatasetPointerType SampleVectorToSample(const VectorType& sample) const;
+
+	ValueType PointSampleFromSample(DatasetConstPointerType sample, unsigned ptid) const {
+		return m_representer->PointSampleFromSample(sample, m_pointIds[ptid]);
+	}
+
+	VectorType PointSampleToPointSampleVector(const ValueType& v) const {
+		return m_representer->PointSampleToPointSampleVector(v);
+	}
+
+	ValueType PointSampleVectorToPointSample(const VectorType& pointSample) const {
+		return m_representer->PointSampleVectorToPointSample(pointSample);
+	}
+
+	void Save(const H5::CommonFG& fg) const;
+
+	unsigned GetPointIdForPoint(const PointType& point) const;
+
+	static void DeleteDataset(DatasetPointerType d) { Representer::DeleteDataset(d); }
+
+	static unsigned MapPointIdToInternalIdx(unsigned ptId, unsigned componentInd) {
+		return ptId * GetDimensions() + componentInd;
+	}
+
+private:
+
+	SubsetRepresenter(const Representer* representer, const PointIdListType& pointIds, const VectorType& referenceSampleVector);
+
+	// to prevent use
+	SubsetRepresenter(const SubsetRepresenter& orig);
+	SubsetRepresenter& operator=(const SubsetRepresenter& rhs);
+
+	const Representer* m_representer;
+	PointIdListType m_pointIds;
+	VectorType m_referenceSampleVector;
+	DomainType m_domain;
+
+	// maps the point ids of the underlying representer to the point ids of the subset
+	std::map<unsigned, unsigned> m_subsetIdMap;
+};
+
+
+} // namespace statismo
+
+#include "SubsetRepresenter.txx"
+
+#endif /* __SUBSETREPRESENTER_H_ */
@@ -0,0 +1,157 @@
+/*
+ * This file is part of the statismo library.
+ *
+ * Author: Marcel Luethi (marcel.luethi@unibas.ch)
+ *
+ * Copyright (c) 2011 University of Basel
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ *
+ * Neither the name of the project's author nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+ * TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS addINTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#include "SubsetRepresenter.h"
+#include "Exceptions.h"
+
+namespace statismo {
+
+
+template <typename Representer>
+SubsetRepresenter<Representer>::SubsetRepresenter(const Representer* representer, const PointIdListType& pointIds, const VectorType& referenceSampleVector)
+: m_representer(representer), m_pointIds(pointIds), m_referenceSampleVector(referenceSampleVector)
+{
+	const typename Representer::DomainType::DomainPointsListType& points = representer->GetDomain().GetDomainPoints();
+
+	typename DomainType::DomainPointsListType subsetPoints;
+	for (unsigned i = 0; i < pointIds.size(); i++) {
+		if (pointIds[i] >= points.size() || m_subsetIdMap.find(pointIds[i]) != m_subsetIdMap.end()) {
+			// the destructor is not called when the constructor throws, hence the representer (which we own) is deleted here
+			const_cast<Representer*>(m_representer)->Delete();
+			if (pointIds[i] >= points.size()) {
+				throw StatisticalModelException("Invalid point id provided to SubsetRepresenter");
+			}
+			throw StatisticalModelException("Duplicate point id provided to SubsetRepresenter");
+		}
+		subsetPoints.push_back(points[pointIds[i]]);
+		m_subsetIdMap[pointIds[i]] = i;
+	}
+	m_domain = DomainType(subsetPoints);
+}
+
+
+template <typename Representer>
+SubsetRepresenter<Representer>*
+SubsetRepresenter<Representer>::Load(const H5::CommonFG& fg) {
+
+	H5::Group representerGroup = fg.openGroup("./underlyingRepresenter");
+	std::string name = HDF5Utils::readStringAttribute(representerGroup, "name");
+	if (name != Representer::GetName()) {
+		throw StatisticalModelException("A different representer was used to create the subset representer.");
+	}
+	Representer* representer = Representer::Load(representerGroup);
+	representerGroup.close();
+
+	std::vector<int> ids;
+	VectorType referenceSampleVector;
+	try {
+		HDF5Utils::readArray(fg, "pointIds", ids);
+		HDF5Utils::readVector(fg, "referenceSampleVector", referenceSampleVector);
+	}
+	catch (...) {
+		representer->Delete();
+		throw;
+	}
+	PointIdListType pointIds(ids.begin(), ids.end());
+
+	// the constructor takes ownership of the representer, also if it throws
+	return new SubsetRepresenter(representer, pointIds, referenceSampleVector);
+}
+
+
+template <typename Representer>
+void
+SubsetRepresenter<Representer>::Save(const H5::CommonFG& fg) const {
+
+	H5::Group representerGroup = fg.createGroup("./underlyingRepresenter");
+	HDF5Utils::writeStringAttribute(representerGroup, "name", Representer::GetName());
+	m_representer->Save(representerGroup);
+	representerGroup.close();
+
+	std::vector<int> ids(m_pointIds.begin(), m_pointIds.end());
+	HDF5Utils::writeArray(fg, "pointIds", ids);
+	HDF5Utils::writeVector(fg, "referenceSampleVector", m_referenceSampleVector);
+}
+
+
+template <typename Representer>
+VectorType
+SubsetRepresenter<Representer>::SampleToSampleVector(DatasetConstPointerType sample) const {
+
+	VectorType fullSampleVector = m_representer->SampleToSampleVector(sample);
+
+	unsigned dim = GetDimensions();
+	VectorType sampleVector(m_pointIds.size() * dim);
+	for (unsigned i = 0; i < m_pointIds.size(); i++) {
+		for (unsigned d = 0; d < dim; d++) {
+			sampleVector[i * dim + d] = fullSampleVector[Representer::MapPointIdToInternalIdx(m_pointIds[i], d)];
+		}
+	}
+	return sampleVector;
+}
+
+
+template <typename Representer>
+typename SubsetRepresenter<Representer>::DatasetPointerType
+SubsetRepresenter<Representer>::SampleVectorToSample(const VectorType& sampleVector) const {
+
+	VectorType fullSampleVector = m_referenceSampleVector;
+
+	unsigned dim = GetDimensions();
+	for (unsigned i = 0; i < m_pointIds.size(); i++) {
+		for (unsigned d = 0; d < dim; d++) {
+			fullSampleVector[Representer::MapPointIdToInternalIdx(m_pointIds[i], d)] = sampleVector[i * dim + d];
+		}
+	}
+	return m_representer->SampleVectorToSample(fullSampleVector);
+}
+
+
+template <typename Representer>
+unsigned
+SubsetRepresenter<Representer>::GetPointIdForPoint(const PointType& point) const {
+
+	std::map<unsigned, unsigned>::const_iterator it = m_subsetIdMap.find(m_representer->GetPointIdForPoint(point));
+	if (it == m_subsetIdMap.end()) {
+		throw StatisticalModelException("The point is not part of the subset represented by the SubsetRepresenter");
+	}
+	return it->second;
+}
+
+
+} // namespace statismo
@@ -41,8 +41,9 @@
 
 #include <fstream>
 #include "Exceptions.h"
-#include <boost/random.hpp>
+#include <boost/cstdint.hpp>
 #include <cstdlib>
+#include <cmath>
 #include <algorithm>
 #include <iterator>
 #include <iostream>
@@ -56,6 +57,134 @@
 
 namespace statismo {
 
+
+/**
+ * \brief A counter based random number generator (Philox4x32-10).
+ *
+ * The numbers of a stream are obtained by encrypting a counter with a key, that is derived from the seed and the stream id.
+ * Hence, streams with the same seed but different stream ids are independent of each other, and the same seed and stream id
+ * always lead to the same numbers. Parallel code should therefore use one stream per thread (or per task), with the thread
+ * (or task) index as stream id. A single stream must not be used concurrently.
+ *
+ * For details, see
+ * Parallel random numbers: as easy as 1, 2, 3, J. Salmon, M. Moraes, R. Dror and D. Shaw, SC 2011
+ */
+class RandomStream {
+public:
+	typedef boost::uint32_t UIntType;
+
+	explicit RandomStream(unsigned seed = 0, unsigned streamId = 0) {
+		Reset(seed, streamId);
+	}
+
+	/** restart the stream with the given seed and stream id */
+	void Reset(unsigned seed, unsigned streamId = 0) {
+		m_key[0] = seed;
+		m_key[1] = streamId;
+		m_counter = 0;
+		m_bufferPos = 4;
+		m_hasSpareNormal = false;
+		m_spareNormal = 0;
+	}
+
+	/** return a random integer, uniformly distributed in [0, 2^32) */
+	UIntType NextUInt() {
+		if (m_bufferPos == 4) {
+			GenerateBlock(m_buffer);
+			m_bufferPos = 0;
+		}
+		return m_buffer[m_bufferPos++];
+	}
+
+	/** return a random integer, uniformly distributed in [0, n) */
+	unsigned NextInt(unsigned n) {
+		return static_cast<unsigned>(NextUniform() * n);
+	}
+
+	/** return a random number, uniformly distributed in (0, 1) */
+	double NextUniform() {
+		return ToUniform(NextUInt());
+	}
+
+	/** return a N(0,1) distributed number */
+	ScalarType NextNormal() {
+		if (m_hasSpareNormal) {
+			m_hasSpareNormal = false;
+			return m_spareNormal;
+		}
+		ScalarType normals[2];
+		BoxMuller(NextUInt(), NextUInt(), normals);
+		m_spareNormal = normals[1];
+		m_hasSpareNormal = true;
+		return normals[0];
+	}
+
+	/**
+	 * fill the given array with n N(0,1) distributed numbers. The numbers are generated a block at a time,
+	 * which is considerably faster than calling NextNormal n times.
+	 */
+	void FillNormal(ScalarType* data, unsigned n) {
+		unsigned i = 0;
+		UIntType block[4];
+		for (; i + 4 <= n; i += 4) {
+			GenerateBlock(block);
+			BoxMuller(block[0], block[1], data + i);
+			BoxMuller(block[2], block[3], data + i + 2);
+		}
+		for (; i < n; i++) {
+			data[i] = NextNormal();
+		}
+	}
+
+private:
+
+	// encrypts the current counter with the key and increments the counter
+	void GenerateBlock(UIntType out[4]) {
+		UIntType c0 = static_cast<UIntType>(m_counter);
+		UIntType c1 = static_cast<UIntType>(m_counter >> 32);
+		UIntType c2 = 0;
+		UIntType c3 = 0;
+		UIntType k0 = m_key[0];
+		UIntType k1 = m_key[1];
+
+		for (unsigned round = 0; round < 10; round++) {
+			boost::uint64_t p0 = static_cast<boost::uint64_t>(0xD2511F53u) * c0;
+			boost::uint64_t p1 = static_cast<boost::uint64_t>(0xCD9E8D57u) * c2;
+			c0 = static_cast<UIntType>(p1 >> 32) ^ c1 ^ k0;
+			c2 = static_cast<UIntType>(p0 >> 32) ^ c3 ^ k1;
+			c1 = static_cast<UIntType>(p1);
+			c3 = static_cast<UIntType>(p0);
+			k0 += 0x9E3779B9u;
+			k1 += 0xBB67AE85u;
+		}
+		out[0] = c0;
+		out[1] = c1;
+		out[2] = c2;
+		out[3] = c3;
+		m_counter++;
+	}
+
+	static double ToUniform(UIntType u) {
+		return (u + 0.5) / 4294967296.0;
+	}
+
+	static void BoxMuller(UIntType u1, UIntType u2, ScalarType* out) {
+		double r = std::sqrt(-2.0 * std::log(ToUniform(u1)));
+		double theta = 2.0 * PI * ToUniform(u2);
+		out[0] = static_cast<ScalarType>(r * std::cos(theta));
+		out[1] = static_cast<ScalarType>(r * std::sin(theta));
+	}
+
+	UIntType m_key[2];
+	boost::uint64_t m_counter;
+	UIntType m_buffer[4];
+	unsigned m_bufferPos;
+	bool m_hasSpareNormal;
+	ScalarType m_spareNormal;
+};
+
+
+
 /**
  * \brief A number of small utility functions - internal use only.
  */
@@ -79,24 +208,48 @@ public:
 	}
 
 
+	/**
+	 * return the random stream that is used whenever no stream is given explicitly. Unless SetRandomSeed is called,
+	 * the stream is seeded with the current time.
+	 * As the stream is shared, it must not be used concurrently. Parallel code should use its own RandomStream instances.
+	 */
+	static RandomStream& GetDefaultRandomStream() {
+		static RandomStream stream(static_cast<unsigned>(time(0)));
+		return stream;
+	}
+
+	/** reseed the default random stream, in order to obtain reproducible results */
+	static void SetRandomSeed(unsigned seed) {
+		GetDefaultRandomStream().Reset(seed);
+	}
+
 	/** return a N(0,1) vector of size n */
-	static VectorType generateNormalVector(unsigned n) {
-		// we would like to use tr1 here as well, but on some versions of visual studio it hangs forever.
-		// therefore we use the functionality from boost
-
-		// we make the random generate static, to ensure that the seed is only set once, and not with
-		// every call
-		static boost::minstd_rand randgen(static_cast<unsigned>(time(0)));
-		static boost::normal_distribution<> dist(0, 1);
-		static boost::variate_generator<boost::minstd_rand, boost::normal_distribution<> > r(randgen, dist);
-
-		VectorType v = VectorType::Zero(n);
-		for (unsigned i=0; i < n; i++) {
-			v(i) = r();
-		}
+	static VectorType generateNormalVector(unsigned n, RandomStream& stream = GetDefaultRandomStream()) {
+		VectorType v(n);
+		stream.FillNormal(v.data(), n);
 		return v;
 	}
 
+	/** return a N(0,1) distributed number. In contrast to generateNormalVector, no memory is allocated */
+	static ScalarType generateNormalScalar(RandomStream& stream = GetDefaultRandomStream()) {
+		return stream.NextNormal();
+	}
+
+	/** return a rows x cols matrix with N(0,1) distributed entries. */
+	static MatrixType generateNormalMatrix(unsigned rows, unsigned cols, RandomStream& stream = GetDefaultRandomStream()) {
+		MatrixType m(rows, cols);
+		stream.FillNormal(m.data(), rows * cols);
+		return m;
+	}
+
+	/** randomly shuffle the elements in the range [first, last) (Fisher-Yates) */
+	template <class RandomAccessIterator>
+	static void randomShuffle(RandomAccessIterator first, RandomAccessIterator last, RandomStream& stream = GetDefaultRandomStream()) {
+		for (long i = static_cast<long>(last - first) - 1; i > 0; i--) {
+			std::swap(first[i], first[stream.NextInt(i + 1)]);
+		}
+	}
+
 
 	static VectorType ReadVectorFromTxtFile(const char *name) {
 		typedef std::list<statismo::ScalarType> ListType;